@@ -0,0 +1,117 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNInputDeviceManager.h"
+#include "VRPNVirtualInputDevice.h"
+#include "VRPNCountingMalloc.h"
+#include "VRPNTestEventSink.h"
+#include "VRPNTestConfig.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+/*
+ * Drives the devices through the device manager for many frames and fails when the steady state allocates.
+ * The simulated sample sources call the same VRPN callbacks as a connection, and the motion controller is queried every frame.
+ * Only the allocations of the test thread are counted, the sleeps between the frames are not.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNAllocationTest, "VRPNInput.NoAllocations", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNAllocationTest::RunTest(const FString &Parameters)
+{
+	FVRPNTestEventSink EventSink;
+	FCriticalSection CritSect;
+	FVRPNInputDeviceManager DeviceManager;
+
+	VRPNTrackerInputDevice *TrackerDevice = new VRPNTrackerInputDevice(TEXT("sim://Rate=1000,Sensors=4"), CritSect);
+	FConfigSection TrackerSection = VRPNTestConfig::MakeTrackerSection(TEXT("VRPNTestTracker"), 4, true);
+	TestTrue(TEXT("Tracker config parsed"), TrackerDevice->ParseConfig(&TrackerSection));
+	DeviceManager.AddInputDevice(TrackerDevice);
+	TrackerDevice->RegisterMotionControllers(DeviceManager.GetMotionController());
+
+	VRPNButtonInputDevice *ButtonDevice = new VRPNButtonInputDevice(TEXT("sim://Rate=240,Sensors=8"), CritSect);
+	FConfigSection ButtonSection = VRPNTestConfig::MakeButtonSection(TEXT("VRPNTestButton"), 8);
+	TestTrue(TEXT("Button config parsed"), ButtonDevice->ParseConfig(&ButtonSection));
+	DeviceManager.AddInputDevice(ButtonDevice);
+
+	VRPNAnalogInputDevice *AnalogDevice = new VRPNAnalogInputDevice(TEXT("sim://Rate=1000,Sensors=4"), CritSect);
+	FConfigSection AnalogSection = VRPNTestConfig::MakeAnalogSection(TEXT("VRPNTestChannel"), 4);
+	TestTrue(TEXT("Analog config parsed"), AnalogDevice->ParseConfig(&AnalogSection));
+	DeviceManager.AddInputDevice(AnalogDevice);
+
+	VRPNVirtualInputDevice *VirtualDevice = new VRPNVirtualInputDevice(CritSect);
+	FConfigSection VirtualSection;
+	VRPNTestConfig::AddConfigValue(VirtualSection, TEXT("Node"), TEXT("(Name=VRPNTestAxis Op=Axis Input=VRPNTestChannel0 Scale=2 Deadzone=0.1 Description=\"Axis\")"));
+	VRPNTestConfig::AddConfigValue(VirtualSection, TEXT("Node"), TEXT("(Name=VRPNTestThreshold Op=Threshold Input=VRPNTestChannel1 On=0.5 Off=0.3 MuteInputs=True Description=\"Threshold\")"));
+	VRPNTestConfig::AddConfigValue(VirtualSection, TEXT("Node"), TEXT("(Name=VRPNTestChord Op=Chord Inputs=VRPNTestButton0+VRPNTestButton1 Description=\"Chord\")"));
+	VRPNTestConfig::AddConfigValue(VirtualSection, TEXT("Node"), TEXT("(Name=VRPNTestRelative Op=RelativePose Input=VRPNTestTracker1 Reference=VRPNTestTracker0 Description=\"Relative\")"));
+	TestTrue(TEXT("Virtual config parsed"), VirtualDevice->ParseConfig(&VirtualSection));
+	DeviceManager.AddVirtualDevice(VirtualDevice);
+	DeviceManager.ResolveVirtualDevices();
+
+	FVRPNMotionController &MotionController = DeviceManager.GetMotionController();
+	TestTrue(TEXT("Motion controllers registered"), MotionController.HasControllers());
+
+	// The first frames may allocate, e.g. the clock estimate of the first samples and the world lookup of the trackers
+	const int32 NumWarmUpFrames = 20;
+	const int32 NumFrames = 500;
+	FVRPNCountingMalloc &CountingMalloc = FVRPNCountingMalloc::Get();
+	CountingMalloc.Install();
+	int32 NumAllocations = 0;
+	int32 FirstAllocatingFrame = INDEX_NONE;
+	for(int32 Frame = 0; Frame < NumWarmUpFrames + NumFrames; ++Frame)
+	{
+		FPlatformProcess::Sleep(0.002f);
+		CountingMalloc.Start();
+		DeviceManager.SendControllerEvents();
+		for(EControllerHand Hand : {EControllerHand::Left, EControllerHand::Right})
+		{
+			FRotator Orientation;
+			FVector Position;
+			MotionController.GetControllerOrientationAndPosition(0, Hand, Orientation, Position);
+			MotionController.GetControllerTrackingStatus(0, Hand);
+		}
+		CountingMalloc.Stop();
+		if(Frame >= NumWarmUpFrames && CountingMalloc.GetNumAllocations() > 0)
+		{
+			NumAllocations += CountingMalloc.GetNumAllocations();
+			if(FirstAllocatingFrame == INDEX_NONE)
+			{
+				FirstAllocatingFrame = Frame - NumWarmUpFrames;
+			}
+		}
+	}
+	CountingMalloc.Uninstall();
+
+	AddLogItem(FString::Printf(TEXT("%i frames sent %lld key and %lld axis events."), NumFrames, EventSink.NumKeyDowns + EventSink.NumKeyUps, EventSink.NumAxes));
+	TestTrue(TEXT("The simulated devices send events"), EventSink.NumKeyDowns > 0 && EventSink.NumAxes > 0);
+	if(NumAllocations > 0)
+	{
+		AddError(FString::Printf(TEXT("The steady state allocated %i times, the first time in frame %i."), NumAllocations, FirstAllocatingFrame));
+	}
+	return NumAllocations == 0;
+}
+
+#endif
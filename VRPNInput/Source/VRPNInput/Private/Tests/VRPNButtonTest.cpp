@@ -0,0 +1,108 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNInputDeviceManager.h"
+#include "VRPNSharedMemory.h"
+#include "VRPNTestEventSink.h"
+#include "VRPNTestConfig.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+namespace
+{
+	void WriteButton(FVRPNSharedMemoryWriter &Writer, int32 ButtonId, bool bPressed)
+	{
+		const double Data[1] = { bPressed ? 1.0 : 0.0 };
+		Writer.Write(EVRPNSharedMemorySampleType::Button, ButtonId, FPlatformTime::Seconds(), Data, ARRAY_COUNT(Data));
+	}
+}
+
+/*
+ * Feeds a button device through a shared memory ring and checks IsButtonPressed() of the device manager and the events of the updates,
+ * including a MaxEventsPerTick that only has room for the first of the two events of a short tap.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNButtonTest, "VRPNInput.Buttons", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNButtonTest::RunTest(const FString &Parameters)
+{
+	const FString RegionName = FString::Printf(TEXT("VRPNButtonTest%u"), FPlatformProcess::GetCurrentProcessId());
+	FVRPNSharedMemoryWriter Writer(RegionName, 64);
+	if(!Writer.IsValid())
+	{
+		AddError(FString::Printf(TEXT("Could not create shared memory region %s."), *RegionName));
+		return false;
+	}
+
+	FVRPNTestEventSink EventSink;
+	FCriticalSection CritSect;
+	FVRPNInputDeviceManager DeviceManager;
+
+	VRPNButtonInputDevice *ButtonDevice = new VRPNButtonInputDevice(TEXT("shm://") + RegionName, CritSect);
+	ButtonDevice->SetDeviceName(TEXT("VRPNTestButtons"));
+	FConfigSection ButtonSection = VRPNTestConfig::MakeButtonSection(TEXT("VRPNTestButton"), 4);
+	VRPNTestConfig::AddConfigValue(ButtonSection, TEXT("MaxEventsPerTick"), TEXT("3"));
+	TestTrue(TEXT("Button config parsed"), ButtonDevice->ParseConfig(&ButtonSection));
+	ButtonDevice->ParseSchedulingConfig(&ButtonSection);
+	DeviceManager.AddInputDevice(ButtonDevice);
+	DeviceManager.AddButtonDevice(ButtonDevice);
+
+	// A press is seen once the update read it from the ring
+	WriteButton(Writer, 2, true);
+	TestTrue(TEXT("Nothing is pressed before the update"), !DeviceManager.IsButtonPressed(TEXT("VRPNTestButtons"), 2));
+	DeviceManager.SendControllerEvents();
+	TestTrue(TEXT("Button 2 is pressed"), DeviceManager.IsButtonPressed(TEXT("VRPNTestButtons"), 2));
+	TestTrue(TEXT("Button 1 is not pressed"), !DeviceManager.IsButtonPressed(TEXT("VRPNTestButtons"), 1));
+	TestTrue(TEXT("Unknown button"), !DeviceManager.IsButtonPressed(TEXT("VRPNTestButtons"), 7));
+	TestTrue(TEXT("Unknown device"), !DeviceManager.IsButtonPressed(TEXT("VRPNNoSuchDevice"), 2));
+	TestEqual(TEXT("Events of the press"), static_cast<int32>(EventSink.GetNumEvents()), 1);
+	if(IVRPNInputPlugin::IsAvailable())
+	{
+		TestTrue(TEXT("The plugin does not know the devices of this test"), !IVRPNInputPlugin::Get().IsButtonPressed(TEXT("VRPNTestButtons"), 2));
+	}
+
+	// Two taps give two events each and a press one, only three fit in an update.
+	// The second tap is halfway after its press and its release follows in the next update with the press of button 3.
+	WriteButton(Writer, 0, true);
+	WriteButton(Writer, 0, false);
+	WriteButton(Writer, 1, true);
+	WriteButton(Writer, 1, false);
+	WriteButton(Writer, 3, true);
+	DeviceManager.SendControllerEvents();
+	TestEqual(TEXT("Events within MaxEventsPerTick"), static_cast<int32>(EventSink.GetNumEvents()), 4);
+	TestEqual(TEXT("Presses in the first update"), static_cast<int32>(EventSink.NumKeyDowns), 3);
+	DeviceManager.SendControllerEvents();
+	TestEqual(TEXT("Events after the second update"), static_cast<int32>(EventSink.GetNumEvents()), 6);
+	TestEqual(TEXT("Presses"), static_cast<int32>(EventSink.NumKeyDowns), 4);
+	TestEqual(TEXT("Releases"), static_cast<int32>(EventSink.NumKeyUps), 2);
+	TestTrue(TEXT("Button 1 is released"), !DeviceManager.IsButtonPressed(TEXT("VRPNTestButtons"), 1));
+	TestTrue(TEXT("Button 3 is pressed"), DeviceManager.IsButtonPressed(TEXT("VRPNTestButtons"), 3));
+	DeviceManager.SendControllerEvents();
+	TestEqual(TEXT("Nothing is send twice"), static_cast<int32>(EventSink.GetNumEvents()), 6);
+	TestEqual(TEXT("Dropped events"), static_cast<int32>(ButtonDevice->GetNumDroppedEvents()), 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNClusterSync.h"
+#include "VRPNSharedMemory.h"
+#include "VRPNTestEventSink.h"
+#include "VRPNTestConfig.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+namespace
+{
+	// The same tracker and button devices on the primary (reading the ring) and on the replica (without a connection)
+	void CreateDevices(const FString &Address, bool bEnabled, FCriticalSection &CritSect, TArray<IVRPNInputDevice*> &OutDevices)
+	{
+		VRPNTrackerInputDevice *TrackerDevice = new VRPNTrackerInputDevice(Address, CritSect, bEnabled);
+		FConfigSection TrackerSection = VRPNTestConfig::MakeTrackerSection(TEXT("VRPNClusterTestTracker"), 1);
+		TrackerDevice->ParseConfig(&TrackerSection);
+		OutDevices.Add(TrackerDevice);
+
+		VRPNButtonInputDevice *ButtonDevice = new VRPNButtonInputDevice(Address, CritSect, bEnabled);
+		FConfigSection ButtonSection = VRPNTestConfig::MakeButtonSection(TEXT("VRPNClusterTestButton"), 2);
+		ButtonDevice->ParseConfig(&ButtonSection);
+		OutDevices.Add(ButtonDevice);
+	}
+
+	void WriteTracker(FVRPNSharedMemoryWriter &Writer, double X)
+	{
+		const double Data[7] = { X, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+		Writer.Write(EVRPNSharedMemorySampleType::Tracker, 0, FPlatformTime::Seconds(), Data, ARRAY_COUNT(Data));
+	}
+
+	void WriteButton(FVRPNSharedMemoryWriter &Writer, int32 ButtonId, bool bPressed)
+	{
+		const double Data[1] = { bPressed ? 1.0 : 0.0 };
+		Writer.Write(EVRPNSharedMemorySampleType::Button, ButtonId, FPlatformTime::Seconds(), Data, ARRAY_COUNT(Data));
+	}
+
+	void UpdateDevices(const TArray<IVRPNInputDevice*> &Devices)
+	{
+		for(IVRPNInputDevice *Device : Devices)
+		{
+			Device->Update();
+		}
+	}
+
+	float GetTrackerX(const TArray<IVRPNInputDevice*> &Devices)
+	{
+		FVector Position;
+		FQuat Rotation;
+		Devices[0]->GetPose(Devices[0]->FindPose(TEXT("VRPNClusterTestTracker0")), Position, Rotation);
+		return Position.X;
+	}
+
+	bool IsButtonPressed(const TArray<IVRPNInputDevice*> &Devices, int32 ButtonId)
+	{
+		return Devices[1]->GetButton(Devices[1]->FindButton(*FString::Printf(TEXT("VRPNClusterTestButton%i"), ButtonId)));
+	}
+}
+
+/*
+ * Writes snapshots on a primary and applies them on a replica without a network in between.
+ * Covers a tap that starts and ends within one primary frame, a frame that arrives out of order and a truncated or corrupt datagram,
+ * which must leave every device of the replica as it was.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNClusterSyncTest, "VRPNInput.ClusterSync", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNClusterSyncTest::RunTest(const FString &Parameters)
+{
+	const FString RegionName = FString::Printf(TEXT("VRPNClusterSyncTest%u"), FPlatformProcess::GetCurrentProcessId());
+	FVRPNSharedMemoryWriter Writer(RegionName, 64);
+	if(!Writer.IsValid())
+	{
+		AddError(FString::Printf(TEXT("Could not create shared memory region %s."), *RegionName));
+		return false;
+	}
+
+	FVRPNTestEventSink EventSink;
+	FCriticalSection CritSect;
+	TArray<IVRPNInputDevice*> PrimaryDevices;
+	TArray<IVRPNInputDevice*> ReplicaDevices;
+	CreateDevices(TEXT("shm://") + RegionName, true, CritSect, PrimaryDevices);
+	CreateDevices(TEXT("VRPNClusterTest@localhost"), false, CritSect, ReplicaDevices);
+	FVRPNClusterSync Primary(FVRPNClusterSync::ERole::Primary);
+	FVRPNClusterSync Replica(FVRPNClusterSync::ERole::Replica);
+
+	// Frame 1: a press
+	WriteTracker(Writer, 1.0);
+	WriteButton(Writer, 0, true);
+	UpdateDevices(PrimaryDevices);
+	TestTrue(TEXT("Frame 1 is applied"), Replica.ApplySnapshot(ReplicaDevices, Primary.WriteSnapshot(PrimaryDevices)));
+	int64 NumKeyDowns = EventSink.NumKeyDowns;
+	int64 NumKeyUps = EventSink.NumKeyUps;
+	UpdateDevices(ReplicaDevices);
+	TestEqual(TEXT("Frame 1 presses"), static_cast<int32>(EventSink.NumKeyDowns - NumKeyDowns), 1);
+	TestTrue(TEXT("Frame 1 button 0"), IsButtonPressed(ReplicaDevices, 0));
+	TestTrue(TEXT("Frame 1 tracker"), FMath::IsNearlyEqual(GetTrackerX(ReplicaDevices), GetTrackerX(PrimaryDevices)));
+
+	// Frame 2: button 1 goes down and up within the frame, the state is the same as in frame 1 but the replica still sees the tap
+	WriteButton(Writer, 1, true);
+	WriteButton(Writer, 1, false);
+	UpdateDevices(PrimaryDevices);
+	const TArray<uint8> Frame2 = Primary.WriteSnapshot(PrimaryDevices);
+	TestTrue(TEXT("Frame 2 is applied"), Replica.ApplySnapshot(ReplicaDevices, Frame2));
+	NumKeyDowns = EventSink.NumKeyDowns;
+	NumKeyUps = EventSink.NumKeyUps;
+	UpdateDevices(ReplicaDevices);
+	TestEqual(TEXT("Frame 2 tap presses"), static_cast<int32>(EventSink.NumKeyDowns - NumKeyDowns), 1);
+	TestEqual(TEXT("Frame 2 tap releases"), static_cast<int32>(EventSink.NumKeyUps - NumKeyUps), 1);
+	TestTrue(TEXT("Frame 2 button 1"), !IsButtonPressed(ReplicaDevices, 1));
+
+	// Frame 3: a release and a move, then frame 2 arrives again out of order and is ignored
+	WriteTracker(Writer, 3.0);
+	WriteButton(Writer, 0, false);
+	UpdateDevices(PrimaryDevices);
+	TestTrue(TEXT("Frame 3 is applied"), Replica.ApplySnapshot(ReplicaDevices, Primary.WriteSnapshot(PrimaryDevices)));
+	TestTrue(TEXT("Frame 2 out of order is ignored"), !Replica.ApplySnapshot(ReplicaDevices, Frame2));
+	UpdateDevices(ReplicaDevices);
+	TestTrue(TEXT("Frame 3 button 0"), !IsButtonPressed(ReplicaDevices, 0));
+	const float Frame3TrackerX = GetTrackerX(PrimaryDevices);
+	TestTrue(TEXT("Frame 3 tracker"), FMath::IsNearlyEqual(GetTrackerX(ReplicaDevices), Frame3TrackerX));
+
+	// Frame 4: the truncated and the corrupt datagram change no device, the whole one does
+	WriteTracker(Writer, 4.0);
+	WriteButton(Writer, 0, true);
+	UpdateDevices(PrimaryDevices);
+	const TArray<uint8> Frame4 = Primary.WriteSnapshot(PrimaryDevices);
+	TArray<uint8> Truncated = Frame4;
+	Truncated.SetNum(Frame4.Num() - 4);
+	TArray<uint8> Corrupt = Frame4;
+	Corrupt.Last() ^= 0xFF;
+	TestTrue(TEXT("Truncated frame 4 is ignored"), !Replica.ApplySnapshot(ReplicaDevices, Truncated));
+	TestTrue(TEXT("Corrupt frame 4 is ignored"), !Replica.ApplySnapshot(ReplicaDevices, Corrupt));
+	NumKeyDowns = EventSink.NumKeyDowns;
+	UpdateDevices(ReplicaDevices);
+	TestEqual(TEXT("No events after the truncated frame"), static_cast<int32>(EventSink.NumKeyDowns - NumKeyDowns), 0);
+	TestTrue(TEXT("Button 0 after the truncated frame"), !IsButtonPressed(ReplicaDevices, 0));
+	TestTrue(TEXT("Tracker after the truncated frame"), FMath::IsNearlyEqual(GetTrackerX(ReplicaDevices), Frame3TrackerX));
+	TestTrue(TEXT("Frame 4 is applied"), Replica.ApplySnapshot(ReplicaDevices, Frame4));
+	UpdateDevices(ReplicaDevices);
+	TestTrue(TEXT("Frame 4 button 0"), IsButtonPressed(ReplicaDevices, 0));
+	TestTrue(TEXT("Frame 4 tracker"), FMath::IsNearlyEqual(GetTrackerX(ReplicaDevices), GetTrackerX(PrimaryDevices)));
+
+	for(IVRPNInputDevice *Device : PrimaryDevices)
+	{
+		delete Device;
+	}
+	for(IVRPNInputDevice *Device : ReplicaDevices)
+	{
+		delete Device;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,174 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNInputDeviceManager.h"
+#include "VRPNConfigCache.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+namespace
+{
+	// Writes a config with as many sections as a large installation, every type is in it
+	FString MakeBenchmarkConfig(int32 NumDevicesPerType)
+	{
+		FString Config;
+		for(int32 DeviceId = 0; DeviceId < NumDevicesPerType; ++DeviceId)
+		{
+			Config += FString::Printf(TEXT("[BenchTracker%i]\nType=Tracker\nAddress=BenchTracker%i@localhost\nFlipZAxis = True\nRotationOffset = (X=1.0 Y=1.0 Z=1.0 Angle=120)\nPositionOffset = (X=0.0 Y=-1.25 Z=0.0)\nTrackerUnitsToUE4Units = 100\n"), DeviceId, DeviceId);
+			for(int32 SensorId = 0; SensorId < 16; ++SensorId)
+			{
+				Config += FString::Printf(TEXT("Tracker = (Id=%i Name=BenchTracker%iSensor%i Description=\"Benchmark tracker %i sensor %i\")\n"), SensorId, DeviceId, SensorId, DeviceId, SensorId);
+			}
+			Config += FString::Printf(TEXT("\n[BenchButtons%i]\nType=Button\nAddress=BenchButtons%i@localhost\n"), DeviceId, DeviceId);
+			for(int32 ButtonId = 0; ButtonId < 32; ++ButtonId)
+			{
+				Config += FString::Printf(TEXT("Button = (Id=%i Name=BenchButtons%iButton%i Description=\"Benchmark button %i of device %i\")\n"), ButtonId, DeviceId, ButtonId, ButtonId, DeviceId);
+			}
+			Config += FString::Printf(TEXT("\n[BenchAnalog%i]\nType=Analog\nAddress=BenchAnalog%i@localhost\n"), DeviceId, DeviceId);
+			for(int32 ChannelId = 0; ChannelId < 16; ++ChannelId)
+			{
+				Config += FString::Printf(TEXT("Channel = (Id=%i Name=BenchAnalog%iChannel%i Description=\"Benchmark channel %i of device %i\")\n"), ChannelId, DeviceId, ChannelId, ChannelId, DeviceId);
+			}
+			Config += FString::Printf(TEXT("\n[BenchVirtual%i]\nType=Virtual\n"), DeviceId);
+			for(int32 NodeId = 0; NodeId < 8; ++NodeId)
+			{
+				Config += FString::Printf(TEXT("Node = (Name=BenchVirtual%iAxis%i Op=Axis Input=BenchAnalog%iChannel%i Scale=2 Deadzone=0.1 Description=\"Benchmark axis\")\n"), DeviceId, NodeId, DeviceId, NodeId);
+				Config += FString::Printf(TEXT("Node = (Name=BenchVirtual%iChord%i Op=Chord Inputs=BenchButtons%iButton%i+BenchButtons%iButton%i Description=\"Benchmark chord\")\n"), DeviceId, NodeId, DeviceId, NodeId, DeviceId, NodeId + 8);
+			}
+			Config += TEXT("\n");
+		}
+		return Config;
+	}
+
+	// Everything the cache stores of a device, a device loaded from the cache must give the same bytes as the parsed device
+	TArray<uint8> SerializeDevice(const FVRPNConfigCache::ConfiguredDevice &Entry)
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		FString SectionName = Entry.Device->GetDeviceName();
+		FString Type = Entry.Type;
+		FString Address = Entry.Address;
+		Writer << SectionName << Type << Address;
+		Entry.Device->SerializeConfig(Writer);
+		return Bytes;
+	}
+
+	void DeleteDevices(TArray<FVRPNConfigCache::ConfiguredDevice> &Devices)
+	{
+		for(const FVRPNConfigCache::ConfiguredDevice &Entry : Devices)
+		{
+			delete Entry.Device;
+		}
+		Devices.Reset();
+	}
+}
+
+/*
+ * Compares the start up time of a large config file parsed from the ini with the same config loaded from the config cache.
+ * Both paths create the same devices, disabled so no connections are made. Every parse starts with the ini unloaded from GConfig,
+ * like the first start of the editor, and every cache load reads and checks the config file like StartupModule does.
+ * The config of every cached device (keys, mappings and scheduling) must be the same as that of the parsed device.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNConfigCacheBenchmark, "VRPNInput.Benchmark.ConfigCache", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNConfigCacheBenchmark::RunTest(const FString &Parameters)
+{
+	const int32 NumDevicesPerType = 32;
+	const int32 NumIterations = 10;
+
+	const FString ConfigFile = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("VRPNBenchmarkConfig.ini"));
+	const FString CacheFile = FVRPNConfigCache(ConfigFile).GetCacheFile();
+	if(!FFileHelper::SaveStringToFile(MakeBenchmarkConfig(NumDevicesPerType), *ConfigFile))
+	{
+		AddError(FString::Printf(TEXT("Could not write %s."), *ConfigFile));
+		return false;
+	}
+	IFileManager::Get().Delete(*CacheFile);
+
+	FCriticalSection CritSect;
+	FVRPNConfigCache::FCreateDeviceFunction CreateDeviceFunction = [&](const FString &Type, const FString &SectionName, const FString &Address)
+	{
+		return FVRPNInputDeviceManager::CreateDevice(Type, SectionName, Address, CritSect, false);
+	};
+
+	TArray<FVRPNConfigCache::ConfiguredDevice> ParsedDevices;
+	TArray<FString> ParsedNames;
+	TArray<TArray<uint8>> ParsedConfigs;
+	double ParseSeconds = 0.0;
+	for(int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		DeleteDevices(ParsedDevices);
+		GConfig->UnloadFile(ConfigFile);
+		const double StartTime = FPlatformTime::Seconds();
+		FVRPNInputDeviceManager::ParseConfigFile(ConfigFile, CreateDeviceFunction, ParsedDevices);
+		ParseSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+	for(const FVRPNConfigCache::ConfiguredDevice &Entry : ParsedDevices)
+	{
+		ParsedNames.Add(Entry.Device->GetDeviceName());
+		ParsedConfigs.Add(SerializeDevice(Entry));
+	}
+	FVRPNConfigCache(ConfigFile).Save(ParsedDevices);
+	DeleteDevices(ParsedDevices);
+	GConfig->UnloadFile(ConfigFile);
+
+	TArray<FVRPNConfigCache::ConfiguredDevice> CachedDevices;
+	double LoadSeconds = 0.0;
+	bool bLoaded = true;
+	for(int32 Iteration = 0; Iteration < NumIterations && bLoaded; ++Iteration)
+	{
+		DeleteDevices(CachedDevices);
+		const double StartTime = FPlatformTime::Seconds();
+		bLoaded = FVRPNConfigCache(ConfigFile).Load(CreateDeviceFunction, CachedDevices);
+		LoadSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+
+	TestTrue(TEXT("The config cache was loaded"), bLoaded);
+	TestEqual(TEXT("Number of parsed devices"), ParsedNames.Num(), NumDevicesPerType * 4);
+	TestEqual(TEXT("Number of cached devices"), CachedDevices.Num(), ParsedNames.Num());
+	for(int32 DeviceIndex = 0; DeviceIndex < CachedDevices.Num() && DeviceIndex < ParsedNames.Num(); ++DeviceIndex)
+	{
+		if(CachedDevices[DeviceIndex].Device->GetDeviceName() != ParsedNames[DeviceIndex])
+		{
+			AddError(FString::Printf(TEXT("Cached device %i is %s but the parsed device is %s."), DeviceIndex, *CachedDevices[DeviceIndex].Device->GetDeviceName(), *ParsedNames[DeviceIndex]));
+		}
+		else if(SerializeDevice(CachedDevices[DeviceIndex]) != ParsedConfigs[DeviceIndex])
+		{
+			AddError(FString::Printf(TEXT("The config of cached device %s is not the same as the config of the parsed device."), *ParsedNames[DeviceIndex]));
+		}
+	}
+	DeleteDevices(CachedDevices);
+
+	const double ParseMs = ParseSeconds * 1000.0 / NumIterations;
+	const double LoadMs = LoadSeconds * 1000.0 / NumIterations;
+	AddLogItem(FString::Printf(TEXT("%i devices: cold parse %.2f ms, config cache %.2f ms (%.1fx faster)."), ParsedNames.Num(), ParseMs, LoadMs, LoadMs > 0.0 ? ParseMs / LoadMs : 0.0));
+
+	IFileManager::Get().Delete(*CacheFile);
+	IFileManager::Get().Delete(*ConfigFile);
+	return true;
+}
+
+#endif
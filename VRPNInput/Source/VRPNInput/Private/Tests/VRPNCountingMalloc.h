@@ -0,0 +1,157 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * Wraps GMalloc and counts the allocations that the test thread makes between Start() and Stop().
+ * Allocations of other threads (the render thread, the task graph) are passed through without being counted.
+ *
+ * There is a single instance that is never destroyed, other threads can still be inside one of its functions
+ * right after Uninstall() restored GMalloc.
+ */
+class FVRPNCountingMalloc : public FMalloc
+{
+public:
+	static FVRPNCountingMalloc& Get()
+	{
+		static FVRPNCountingMalloc Instance;
+		return Instance;
+	}
+
+	void Install()
+	{
+		check(InnerMalloc == nullptr);
+		InnerMalloc = GMalloc;
+		GMalloc = this;
+	}
+
+	void Uninstall()
+	{
+		check(GMalloc == this);
+		Stop();
+		GMalloc = InnerMalloc;
+		InnerMalloc = nullptr;
+	}
+
+	// Starts counting the allocations of the calling thread
+	void Start()
+	{
+		NumAllocations = 0;
+		CountedThreadId = FPlatformTLS::GetCurrentThreadId();
+	}
+
+	void Stop()
+	{
+		CountedThreadId = 0;
+	}
+
+	int32 GetNumAllocations() const { return NumAllocations; }
+
+	// FMalloc interface, everything is passed to the wrapped allocator
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if(Count > 0)
+		{
+			CountAllocation();
+		}
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual bool GetAllocationSize(void *Original, SIZE_T &SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim() override
+	{
+		InnerMalloc->Trim();
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual void UpdateStats() override
+	{
+		InnerMalloc->UpdateStats();
+	}
+
+	virtual void GetAllocatorStats(FGenericMemoryStats &OutStats) override
+	{
+		InnerMalloc->GetAllocatorStats(OutStats);
+	}
+
+	virtual void DumpAllocatorStats(FOutputDevice &Ar) override
+	{
+		InnerMalloc->DumpAllocatorStats(Ar);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual bool ValidateHeap() override
+	{
+		return InnerMalloc->ValidateHeap();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return InnerMalloc->GetDescriptiveName();
+	}
+
+private:
+	FVRPNCountingMalloc() : InnerMalloc(nullptr), CountedThreadId(0), NumAllocations(0) {}
+
+	void CountAllocation()
+	{
+		if(CountedThreadId != 0 && FPlatformTLS::GetCurrentThreadId() == CountedThreadId)
+		{
+			++NumAllocations;
+		}
+	}
+
+	FMalloc *InnerMalloc;
+	volatile uint32 CountedThreadId;
+	int32 NumAllocations;
+};
@@ -0,0 +1,104 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNSharedMemory.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNSharedMemoryTest, "VRPNInput.SharedMemory", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNSharedMemoryTest::RunTest(const FString &Parameters)
+{
+	const uint32 Capacity = 16;
+	const FString RegionName = FString::Printf(TEXT("VRPNSharedMemoryTest%u"), FPlatformProcess::GetCurrentProcessId());
+	TSharedPtr<FVRPNSharedMemoryWriter> Writer(new FVRPNSharedMemoryWriter(RegionName, Capacity));
+	if(!Writer->IsValid())
+	{
+		AddError(FString::Printf(TEXT("Could not create shared memory region %s."), *RegionName));
+		return false;
+	}
+	FVRPNSharedMemoryReader Reader(TEXT("shm://") + RegionName);
+
+	FVRPNSharedMemorySample Samples[2 * Capacity];
+
+	// Everything that fits in the ring arrives in order
+	const int32 NumWritten = 10;
+	for(int32 i = 0; i < NumWritten; ++i)
+	{
+		const double Data[7] = { double(i), 1.0, 2.0, 0.0, 0.0, 0.0, 1.0 };
+		Writer->Write(EVRPNSharedMemorySampleType::Tracker, i % 3, 1000.0 + i, Data, ARRAY_COUNT(Data));
+	}
+	int32 NumRead = Reader.Poll(Samples, ARRAY_COUNT(Samples));
+	TestEqual(TEXT("Samples read from the ring"), NumRead, NumWritten);
+	for(int32 i = 0; i < NumRead; ++i)
+	{
+		TestEqual(TEXT("Sample sensor"), Samples[i].Sensor, i % 3);
+		TestEqual(TEXT("Sample data"), Samples[i].Data[0], double(i));
+		TestTrue(TEXT("Sample type"), Samples[i].Type == EVRPNSharedMemorySampleType::Tracker);
+	}
+	TestEqual(TEXT("Nothing is read twice"), Reader.Poll(Samples, ARRAY_COUNT(Samples)), 0);
+
+	// A reader that falls behind more than the capacity skips ahead and counts what it missed
+	for(int32 i = 0; i < 2 * int32(Capacity); ++i)
+	{
+		const double Data[1] = { double(i % 2) };
+		Writer->Write(EVRPNSharedMemorySampleType::Button, i, 2000.0 + i, Data, ARRAY_COUNT(Data));
+	}
+	NumRead = Reader.Poll(Samples, ARRAY_COUNT(Samples));
+	TestEqual(TEXT("Samples read after the writer lapped the reader"), NumRead, int32(Capacity));
+	TestEqual(TEXT("Lost samples"), Reader.GetNumLostSamples(), int64(Capacity));
+	if(NumRead > 0)
+	{
+		TestEqual(TEXT("First sample after skipping ahead"), Samples[0].Sensor, int32(Capacity));
+	}
+
+	// A restarted bridge creates the region again and counts from zero, the reader has to open it again and read the new session
+	Writer.Reset();
+	Writer = TSharedPtr<FVRPNSharedMemoryWriter>(new FVRPNSharedMemoryWriter(RegionName, Capacity));
+	if(!Writer->IsValid())
+	{
+		AddError(FString::Printf(TEXT("Could not create shared memory region %s again."), *RegionName));
+		return false;
+	}
+	const int32 NumWrittenAfterRestart = 3;
+	for(int32 i = 0; i < NumWrittenAfterRestart; ++i)
+	{
+		const double Data[1] = { 1.0 };
+		Writer->Write(EVRPNSharedMemorySampleType::Button, 100 + i, 3000.0 + i, Data, ARRAY_COUNT(Data));
+	}
+	// A region that was removed and created again is only found by the check that runs every second while nothing arrives
+	FPlatformProcess::Sleep(1.1f);
+	NumRead = Reader.Poll(Samples, ARRAY_COUNT(Samples));
+	TestEqual(TEXT("Samples read after the bridge restarted"), NumRead, NumWrittenAfterRestart);
+	if(NumRead > 0)
+	{
+		TestEqual(TEXT("First sample of the new session"), Samples[0].Sensor, 100);
+	}
+	TestEqual(TEXT("A restart does not count as lost samples"), Reader.GetNumLostSamples(), int64(Capacity));
+	return true;
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNInputDeviceManager.h"
+#include "VRPNCountingMalloc.h"
+#include "VRPNTestEventSink.h"
+#include "VRPNTestConfig.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+namespace
+{
+	// The statistics are reset through DumpStats(), the text is not needed
+	class FVRPNNullOutputDevice : public FOutputDevice
+	{
+	public:
+		void Serialize(const TCHAR *V, ELogVerbosity::Type Verbosity, const class FName &Category) override {}
+	};
+
+	// Statistics of one window of the soak test
+	struct SoakWindow
+	{
+		double MeanFrameTime;
+		int32 MaxQueueDepth;
+		uint64 UsedPhysical;
+	};
+}
+
+/*
+ * Runs simulated devices through the device manager for -VRPNSoakSeconds= (default 10) and checks, per window of a second, that
+ * the queue depth stays bounded, no samples or button events are lost, nothing is allocated and the cost of a frame and the memory use do not grow.
+ * The buttons hold their state for 100 reports (100 ms), longer than a frame, so every change must give exactly one event.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNSoakTest, "VRPNInput.Soak", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNSoakTest::RunTest(const FString &Parameters)
+{
+	float SoakSeconds = 10.0f;
+	FParse::Value(FCommandLine::Get(), TEXT("VRPNSoakSeconds="), SoakSeconds);
+	const double WindowSeconds = 1.0;
+	const int32 NumWarmUpFrames = 20;
+	const int32 ButtonRate = 1000;
+	const int32 NumButtons = 32;
+	const int32 ButtonHold = 100;
+	// A device that can not keep up leaves more and more reports for each update, this is a quarter of a second of the busiest device
+	const int32 MaxQueueDepth = ButtonRate * NumButtons / 4;
+	// The cost of a frame may vary with the machine load, but not double
+	const double MaxFrameTimeGrowth = 2.0;
+	const double FrameTimeSlack = 0.0002;
+	// The plugin does not allocate during the updates, this leaves room for the rest of the process (the log, the automation framework)
+	const double MaxMemoryGrowthMB = 32.0;
+
+	FVRPNTestEventSink EventSink;
+	FCriticalSection CritSect;
+	FVRPNInputDeviceManager DeviceManager;
+	TArray<IVRPNInputDevice*> Devices;
+
+	VRPNTrackerInputDevice *TrackerDevice = new VRPNTrackerInputDevice(TEXT("sim://Rate=1000,Sensors=16"), CritSect);
+	FConfigSection TrackerSection = VRPNTestConfig::MakeTrackerSection(TEXT("VRPNSoakTracker"), 16);
+	TestTrue(TEXT("Tracker config parsed"), TrackerDevice->ParseConfig(&TrackerSection));
+	Devices.Add(TrackerDevice);
+
+	VRPNButtonInputDevice *ButtonDevice = new VRPNButtonInputDevice(FString::Printf(TEXT("sim://Rate=%i,Sensors=%i,Hold=%i"), ButtonRate, NumButtons, ButtonHold), CritSect);
+	FConfigSection ButtonSection = VRPNTestConfig::MakeButtonSection(TEXT("VRPNSoakButton"), NumButtons);
+	TestTrue(TEXT("Button config parsed"), ButtonDevice->ParseConfig(&ButtonSection));
+	Devices.Add(ButtonDevice);
+
+	VRPNAnalogInputDevice *AnalogDevice = new VRPNAnalogInputDevice(TEXT("sim://Rate=1000,Sensors=8"), CritSect);
+	FConfigSection AnalogSection = VRPNTestConfig::MakeAnalogSection(TEXT("VRPNSoakChannel"), 8);
+	TestTrue(TEXT("Analog config parsed"), AnalogDevice->ParseConfig(&AnalogSection));
+	Devices.Add(AnalogDevice);
+
+	for(IVRPNInputDevice *Device : Devices)
+	{
+		DeviceManager.AddInputDevice(Device);
+	}
+
+	FVRPNNullOutputDevice NullOutput;
+	for(int32 Frame = 0; Frame < NumWarmUpFrames; ++Frame)
+	{
+		FPlatformProcess::Sleep(0.004f);
+		DeviceManager.SendControllerEvents();
+	}
+	for(IVRPNInputDevice *Device : Devices)
+	{
+		Device->DumpStats(NullOutput, 1.0);
+	}
+
+	TArray<SoakWindow> Windows;
+	Windows.Reserve(FMath::CeilToInt(SoakSeconds / WindowSeconds) + 1);
+	const int64 FirstKeyEvents = EventSink.NumKeyDowns + EventSink.NumKeyUps;
+	int64 NumLosses = 0;
+	int32 NumAllocations = 0;
+	double WindowFrameTime = 0.0;
+	int32 NumWindowFrames = 0;
+
+	FVRPNCountingMalloc &CountingMalloc = FVRPNCountingMalloc::Get();
+	CountingMalloc.Install();
+	const double StartTime = FPlatformTime::Seconds();
+	double WindowStartTime = StartTime;
+	double CurrentTime = StartTime;
+	while(CurrentTime - StartTime < SoakSeconds)
+	{
+		FPlatformProcess::Sleep(0.004f);
+		const double FrameStartTime = FPlatformTime::Seconds();
+		CountingMalloc.Start();
+		DeviceManager.SendControllerEvents();
+		CountingMalloc.Stop();
+		CurrentTime = FPlatformTime::Seconds();
+		NumAllocations += CountingMalloc.GetNumAllocations();
+		WindowFrameTime += CurrentTime - FrameStartTime;
+		++NumWindowFrames;
+
+		if(CurrentTime - WindowStartTime >= WindowSeconds)
+		{
+			SoakWindow Window = {WindowFrameTime / NumWindowFrames, 0, FPlatformMemory::GetStats().UsedPhysical};
+			for(IVRPNInputDevice *Device : Devices)
+			{
+				Window.MaxQueueDepth = FMath::Max(Window.MaxQueueDepth, Device->GetStats().MaxQueueDepth);
+				NumLosses += Device->DumpStats(NullOutput, CurrentTime - WindowStartTime);
+			}
+			Windows.Add(Window);
+			WindowStartTime = CurrentTime;
+			WindowFrameTime = 0.0;
+			NumWindowFrames = 0;
+		}
+	}
+	CountingMalloc.Uninstall();
+	const double SoakTime = CurrentTime - StartTime;
+
+	// Every button changes state once per hold, each change is one event
+	const int64 NumKeyEvents = EventSink.NumKeyDowns + EventSink.NumKeyUps - FirstKeyEvents;
+	const int64 NumExpectedKeyEvents = static_cast<int64>(SoakTime * ButtonRate / ButtonHold * NumButtons);
+	AddLogItem(FString::Printf(TEXT("%.1f s: %lld key events (%lld expected), %lld axis events."), SoakTime, NumKeyEvents, NumExpectedKeyEvents, EventSink.NumAxes));
+
+	if(Windows.Num() < 2)
+	{
+		AddError(FString::Printf(TEXT("The soak test needs at least two windows of %.0f s, use a longer -VRPNSoakSeconds=."), WindowSeconds));
+		return false;
+	}
+	bool bSucceeded = true;
+	const double MemoryGrowthMB = (static_cast<double>(Windows.Last().UsedPhysical) - static_cast<double>(Windows[0].UsedPhysical)) / (1024.0 * 1024.0);
+	AddLogItem(FString::Printf(TEXT("Physical memory grew %+.1f MB from the first to the last window."), MemoryGrowthMB));
+	if(MemoryGrowthMB > MaxMemoryGrowthMB)
+	{
+		AddError(FString::Printf(TEXT("Physical memory grew %.1f MB from the first to the last window, at most %.0f MB is expected."), MemoryGrowthMB, MaxMemoryGrowthMB));
+		bSucceeded = false;
+	}
+	for(int32 WindowIndex = 0; WindowIndex < Windows.Num(); ++WindowIndex)
+	{
+		const SoakWindow &Window = Windows[WindowIndex];
+		AddLogItem(FString::Printf(TEXT("Window %i: frame mean %.3f ms, max queue depth %i, %.1f MB physical memory."), WindowIndex, Window.MeanFrameTime * 1000.0, Window.MaxQueueDepth,
+			Window.UsedPhysical / (1024.0 * 1024.0)));
+		if(Window.MaxQueueDepth > MaxQueueDepth)
+		{
+			AddError(FString::Printf(TEXT("Window %i: %i reports waited for an update, at most %i are expected."), WindowIndex, Window.MaxQueueDepth, MaxQueueDepth));
+			bSucceeded = false;
+		}
+		if(Window.MeanFrameTime > Windows[0].MeanFrameTime * MaxFrameTimeGrowth + FrameTimeSlack)
+		{
+			AddError(FString::Printf(TEXT("Window %i: a frame took %.3f ms, the first window %.3f ms."), WindowIndex, Window.MeanFrameTime * 1000.0, Windows[0].MeanFrameTime * 1000.0));
+			bSucceeded = false;
+		}
+	}
+	if(NumLosses > 0)
+	{
+		AddError(FString::Printf(TEXT("%lld samples or events were lost."), NumLosses));
+		bSucceeded = false;
+	}
+	// A change can be on either side of the start or end of the soak
+	if(FMath::Abs(NumKeyEvents - NumExpectedKeyEvents) > NumExpectedKeyEvents / 20 + NumButtons * 2)
+	{
+		AddError(FString::Printf(TEXT("%lld key events were send, %lld were expected."), NumKeyEvents, NumExpectedKeyEvents));
+		bSucceeded = false;
+	}
+	if(NumAllocations > 0)
+	{
+		AddError(FString::Printf(TEXT("The soak test allocated %i times during the updates."), NumAllocations));
+		bSucceeded = false;
+	}
+	return bSucceeded;
+}
+
+#endif
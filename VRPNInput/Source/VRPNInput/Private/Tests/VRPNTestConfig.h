@@ -0,0 +1,81 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNInputDevice.h"
+
+/*
+ * Builds the config sections of the devices in the tests, the same as a section of the config file would give.
+ * Every key is named <NamePrefix><Id>.
+ */
+namespace VRPNTestConfig
+{
+	inline void AddConfigValue(FConfigSection &Section, const TCHAR *Key, const FString &Value)
+	{
+		Section.Add(FName(Key), FConfigValue(Value));
+	}
+
+	// Trackers in meters, with motion controllers trackers 1 and 2 are the left and right hand of player 0
+	inline FConfigSection MakeTrackerSection(const TCHAR *NamePrefix, int32 NumTrackers, bool bMotionControllers = false)
+	{
+		FConfigSection Section;
+		AddConfigValue(Section, TEXT("TrackerUnitsToUE4Units"), TEXT("100"));
+		AddConfigValue(Section, TEXT("FlipZAxis"), TEXT("false"));
+		for(int32 TrackerId = 0; TrackerId < NumTrackers; ++TrackerId)
+		{
+			const TCHAR *MotionController = TEXT("");
+			if(bMotionControllers && TrackerId == 1)
+			{
+				MotionController = TEXT(" PlayerId=0 Hand=Left");
+			}
+			else if(bMotionControllers && TrackerId == 2)
+			{
+				MotionController = TEXT(" PlayerId=0 Hand=Right");
+			}
+			AddConfigValue(Section, TEXT("Tracker"), FString::Printf(TEXT("(Id=%i Name=%s%i Description=\"Tracker\"%s)"), TrackerId, NamePrefix, TrackerId, MotionController));
+		}
+		return Section;
+	}
+
+	inline FConfigSection MakeButtonSection(const TCHAR *NamePrefix, int32 NumButtons)
+	{
+		FConfigSection Section;
+		for(int32 ButtonId = 0; ButtonId < NumButtons; ++ButtonId)
+		{
+			AddConfigValue(Section, TEXT("Button"), FString::Printf(TEXT("(Id=%i Name=%s%i Description=\"Button\")"), ButtonId, NamePrefix, ButtonId));
+		}
+		return Section;
+	}
+
+	inline FConfigSection MakeAnalogSection(const TCHAR *NamePrefix, int32 NumChannels)
+	{
+		FConfigSection Section;
+		for(int32 ChannelId = 0; ChannelId < NumChannels; ++ChannelId)
+		{
+			AddConfigValue(Section, TEXT("Channel"), FString::Printf(TEXT("(Id=%i Name=%s%i Description=\"Channel\")"), ChannelId, NamePrefix, ChannelId));
+		}
+		return Section;
+	}
+}
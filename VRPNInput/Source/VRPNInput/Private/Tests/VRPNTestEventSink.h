@@ -0,0 +1,71 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNInputDevice.h"
+
+/*
+ * Counts the events of the devices instead of sending them to Slate, so the tests do not send input to the engine.
+ * Installed for the lifetime of the object.
+ */
+class FVRPNTestEventSink : public IVRPNEventSink
+{
+public:
+	FVRPNTestEventSink() : NumKeyDowns(0), NumKeyUps(0), NumAxes(0), AxisSum(0.0)
+	{
+		IVRPNInputDevice::SetEventSink(this);
+	}
+
+	virtual ~FVRPNTestEventSink()
+	{
+		IVRPNInputDevice::SetEventSink(nullptr);
+	}
+
+	void SendKey(const FKey &Key, bool bPressed, const FModifierKeysState &ModifierKeys) override
+	{
+		if(bPressed)
+		{
+			++NumKeyDowns;
+		}
+		else
+		{
+			++NumKeyUps;
+		}
+	}
+
+	void SendAxis(const FKey &Key, float Value, const FModifierKeysState &ModifierKeys) override
+	{
+		++NumAxes;
+		// Used by the benchmarks so the values are not optimized away
+		AxisSum += Value;
+	}
+
+	int64 GetNumEvents() const { return NumKeyDowns + NumKeyUps + NumAxes; }
+
+	int64 NumKeyDowns;
+	int64 NumKeyUps;
+	int64 NumAxes;
+	double AxisSum;
+};
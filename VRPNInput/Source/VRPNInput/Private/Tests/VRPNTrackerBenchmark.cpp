@@ -0,0 +1,282 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNInputDevice.h"
+#include "VRPNTestEventSink.h"
+#include "VRPNTestConfig.h"
+#include "AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 NumSensors = 64;
+	// A 1000 Hz tracker gives about 16 reports per sensor in a 60 Hz frame
+	const int32 NumReportsPerFrame = 16;
+	const int32 NumFrames = 2000;
+	// Touched between frames so the tracker state is no longer in the cache, like after the rest of a game frame
+	const int32 EvictBytes = 16 * 1024 * 1024;
+	// The results of the loops are stored here so they are not optimized away
+	volatile double BenchmarkResult = 0.0;
+
+	// The layout before the hot and cold split, a copy of the original VRPNTrackerInputDevice::TrackerInput: one map element per tracker with the keys next to the pose
+	struct OldTrackerInput
+	{
+		FKey MotionXKey;
+		FKey MotionYKey;
+		FKey MotionZKey;
+
+		FKey RotationYawKey;
+		FKey RotationPitchKey;
+		FKey RotationRollKey;
+
+		FVector CurrentTrackerPosition;
+		FQuat CurrentTrackerRotation;
+
+		// for motion controllers
+		int PlayerIndex;
+		EControllerHand Hand;
+
+		bool TrackerDataDirty;
+	};
+
+	// The current layout, the same as VRPNTrackerInputDevice::TrackerSample and TrackerInfo
+	struct NewTrackerSample
+	{
+		FQuat CurrentTrackerRotation;
+		FVector CurrentTrackerPosition;
+		bool TrackerDataDirty;
+		double SampleTime;
+	};
+	struct NewTrackerInfo
+	{
+		FKey Keys[IVRPNInputDevice::NumPoseAxes];
+		FName TrackerName;
+		int32 TrackerId;
+		int PlayerIndex;
+		EControllerHand Hand;
+		uint8 MutedAxes;
+	};
+
+	struct LayoutTimes
+	{
+		LayoutTimes() : ReportTime(0.0), UpdateTime(0.0) {}
+		double ReportTime;
+		double UpdateTime;
+	};
+
+	void EvictCache(TArray<uint8> &EvictBuffer)
+	{
+		for(int32 i = 0; i < EvictBuffer.Num(); i += 64)
+		{
+			++EvictBuffer[i];
+		}
+	}
+
+	FKey MakeAxisKey(int32 Sensor, int32 Axis)
+	{
+		return FKey(*FString::Printf(TEXT("VRPNBenchmarkTracker%i%s"), Sensor, IVRPNInputDevice::PoseAxisKeySuffixes[Axis]));
+	}
+
+	// The callbacks write a report per sensor, then the update reads every dirty pose and its keys
+	LayoutTimes RunOldLayout(TArray<uint8> &EvictBuffer, float &OutSum)
+	{
+		TMap<int32, OldTrackerInput> Trackers;
+		for(int32 Sensor = 0; Sensor < NumSensors; ++Sensor)
+		{
+			OldTrackerInput Input;
+			Input.MotionXKey = MakeAxisKey(Sensor, 0);
+			Input.MotionYKey = MakeAxisKey(Sensor, 1);
+			Input.MotionZKey = MakeAxisKey(Sensor, 2);
+			Input.RotationYawKey = MakeAxisKey(Sensor, 3);
+			Input.RotationPitchKey = MakeAxisKey(Sensor, 4);
+			Input.RotationRollKey = MakeAxisKey(Sensor, 5);
+			Input.CurrentTrackerPosition = FVector::ZeroVector;
+			Input.CurrentTrackerRotation = FQuat::Identity;
+			Input.PlayerIndex = -1;
+			Input.Hand = EControllerHand::Left;
+			Input.TrackerDataDirty = false;
+			Trackers.Add(Sensor, Input);
+		}
+
+		LayoutTimes Times;
+		for(int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			EvictCache(EvictBuffer);
+			double StartTime = FPlatformTime::Seconds();
+			for(int32 Report = 0; Report < NumReportsPerFrame; ++Report)
+			{
+				for(int32 Sensor = 0; Sensor < NumSensors; ++Sensor)
+				{
+					OldTrackerInput *Input = Trackers.Find(Sensor);
+					Input->CurrentTrackerPosition = FVector(Report, Sensor, Frame);
+					Input->CurrentTrackerRotation = FQuat(0.0f, 0.0f, 0.0f, 1.0f);
+					Input->TrackerDataDirty = true;
+				}
+			}
+			Times.ReportTime += FPlatformTime::Seconds() - StartTime;
+
+			EvictCache(EvictBuffer);
+			StartTime = FPlatformTime::Seconds();
+			for(auto &Entry : Trackers)
+			{
+				OldTrackerInput &Input = Entry.Value;
+				if(!Input.TrackerDataDirty)
+				{
+					continue;
+				}
+				Input.TrackerDataDirty = false;
+				const FKey *Keys[IVRPNInputDevice::NumPoseAxes] = { &Input.MotionXKey, &Input.MotionYKey, &Input.MotionZKey, &Input.RotationYawKey, &Input.RotationPitchKey, &Input.RotationRollKey };
+				for(int32 Axis = 0; Axis < IVRPNInputDevice::NumPoseAxes; ++Axis)
+				{
+					OutSum += Keys[Axis]->GetFName().GetNumber() + Input.CurrentTrackerPosition[Axis % 3];
+				}
+			}
+			Times.UpdateTime += FPlatformTime::Seconds() - StartTime;
+		}
+		return Times;
+	}
+
+	LayoutTimes RunNewLayout(TArray<uint8> &EvictBuffer, float &OutSum)
+	{
+		TArray<int32> Slots;
+		TArray<NewTrackerSample> Samples;
+		TArray<NewTrackerInfo> Infos;
+		Slots.Init(INDEX_NONE, NumSensors);
+		for(int32 Sensor = 0; Sensor < NumSensors; ++Sensor)
+		{
+			Slots[Sensor] = Samples.Num();
+			Samples.Add({FQuat::Identity, FVector::ZeroVector, false, 0.0});
+			NewTrackerInfo &Info = Infos[Infos.AddDefaulted()];
+			for(int32 Axis = 0; Axis < IVRPNInputDevice::NumPoseAxes; ++Axis)
+			{
+				Info.Keys[Axis] = MakeAxisKey(Sensor, Axis);
+			}
+			Info.TrackerName = FName(*FString::Printf(TEXT("VRPNBenchmarkTracker%i"), Sensor));
+			Info.TrackerId = Sensor;
+			Info.PlayerIndex = -1;
+			Info.Hand = EControllerHand::Left;
+			Info.MutedAxes = 0;
+		}
+
+		LayoutTimes Times;
+		for(int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			EvictCache(EvictBuffer);
+			double StartTime = FPlatformTime::Seconds();
+			for(int32 Report = 0; Report < NumReportsPerFrame; ++Report)
+			{
+				for(int32 Sensor = 0; Sensor < NumSensors; ++Sensor)
+				{
+					NewTrackerSample &Sample = Samples[Slots[Sensor]];
+					Sample.CurrentTrackerPosition = FVector(Report, Sensor, Frame);
+					Sample.CurrentTrackerRotation = FQuat(0.0f, 0.0f, 0.0f, 1.0f);
+					Sample.SampleTime = Frame;
+					Sample.TrackerDataDirty = true;
+				}
+			}
+			Times.ReportTime += FPlatformTime::Seconds() - StartTime;
+
+			EvictCache(EvictBuffer);
+			StartTime = FPlatformTime::Seconds();
+			for(int32 Slot = 0; Slot < Samples.Num(); ++Slot)
+			{
+				NewTrackerSample &Sample = Samples[Slot];
+				if(!Sample.TrackerDataDirty)
+				{
+					continue;
+				}
+				Sample.TrackerDataDirty = false;
+				const NewTrackerInfo &Info = Infos[Slot];
+				for(int32 Axis = 0; Axis < IVRPNInputDevice::NumPoseAxes; ++Axis)
+				{
+					OutSum += Info.Keys[Axis].GetFName().GetNumber() + Sample.CurrentTrackerPosition[Axis % 3];
+				}
+			}
+			Times.UpdateTime += FPlatformTime::Seconds() - StartTime;
+		}
+		return Times;
+	}
+}
+
+/*
+ * Compares the tracker state layout before and after the hot and cold split for 64 sensors, and measures the update of a real
+ * tracker device with 64 simulated sensors. The cache is flushed between the phases, so the times include the cache misses.
+ * Only the results are logged, the times depend too much on the machine to be checked.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPNTrackerBenchmark, "VRPNInput.Benchmark.Tracker", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FVRPNTrackerBenchmark::RunTest(const FString &Parameters)
+{
+	TArray<uint8> EvictBuffer;
+	EvictBuffer.AddZeroed(EvictBytes);
+	float OldSum = 0.0f;
+	float NewSum = 0.0f;
+
+	const int64 NumReports = int64(NumFrames) * NumReportsPerFrame * NumSensors;
+	const LayoutTimes OldTimes = RunOldLayout(EvictBuffer, OldSum);
+	const LayoutTimes NewTimes = RunNewLayout(EvictBuffer, NewSum);
+	AddLogItem(FString::Printf(TEXT("Tracker state of %i sensors, map of TrackerInput: %i bytes per TrackerInput, %.1f ns per report, %.2f us per update."),
+		NumSensors, int32(sizeof(OldTrackerInput)), OldTimes.ReportTime * 1.0e9 / NumReports, OldTimes.UpdateTime * 1.0e6 / NumFrames));
+	AddLogItem(FString::Printf(TEXT("Tracker state of %i sensors, hot and cold arrays: %i bytes written per report, %i bytes per tracker in total, %.1f ns per report, %.2f us per update."),
+		NumSensors, int32(sizeof(NewTrackerSample)), int32(sizeof(NewTrackerSample) + sizeof(NewTrackerInfo) + sizeof(int32)),
+		NewTimes.ReportTime * 1.0e9 / NumReports, NewTimes.UpdateTime * 1.0e6 / NumFrames));
+	// Both loops visit the trackers in the same order and do the same math, so they only differ in the layout they time
+	TestTrue(TEXT("Both layouts read the same poses and keys"), OldSum == NewSum);
+
+	// A real device, the sample source generates the reports for the time that passed since the previous update
+	FVRPNTestEventSink EventSink;
+	FCriticalSection CritSect;
+	VRPNTrackerInputDevice Device(FString::Printf(TEXT("sim://Rate=1000,Sensors=%i"), NumSensors), CritSect);
+	FConfigSection Section = VRPNTestConfig::MakeTrackerSection(TEXT("VRPNBenchmarkTracker"), NumSensors);
+	if(!Device.ParseConfig(&Section))
+	{
+		AddError(TEXT("Could not parse the tracker config."));
+		return false;
+	}
+
+	const int32 NumDeviceFrames = 500;
+	double TotalUpdateTime = 0.0;
+	double MaxUpdateTime = 0.0;
+	for(int32 Frame = 0; Frame < NumDeviceFrames; ++Frame)
+	{
+		FPlatformProcess::Sleep(0.002f);
+		EvictCache(EvictBuffer);
+		const double StartTime = FPlatformTime::Seconds();
+		Device.Update();
+		const double UpdateTime = FPlatformTime::Seconds() - StartTime;
+		TotalUpdateTime += UpdateTime;
+		MaxUpdateTime = FMath::Max(MaxUpdateTime, UpdateTime);
+	}
+	AddLogItem(FString::Printf(TEXT("Tracker device with %i simulated sensors at 1000 Hz: %lld axis events, %.2f us mean and %.2f us max per update."),
+		NumSensors, EventSink.NumAxes, TotalUpdateTime * 1.0e6 / NumDeviceFrames, MaxUpdateTime * 1.0e6));
+	TestTrue(TEXT("The simulated trackers send events"), EventSink.NumAxes > 0);
+	TestTrue(TEXT("Every updated tracker sends all its axes"), EventSink.NumAxes % IVRPNInputDevice::NumPoseAxes == 0);
+
+	BenchmarkResult = OldSum + NewSum + EventSink.AxisSum;
+	return true;
+}
+
+#endif
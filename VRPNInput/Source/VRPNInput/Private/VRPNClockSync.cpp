@@ -0,0 +1,157 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNClockSync.h"
+
+namespace
+{
+	const double BlockDuration = 1.0;
+	// A new minimum that is this far from the estimate means the server clock was changed, start over
+	const double MaxOffsetJump = 0.5;
+
+	double ToSeconds(const timeval &Time)
+	{
+		return Time.tv_sec + Time.tv_usec * 0.000001;
+	}
+}
+
+FVRPNClockSync::FVRPNClockSync():
+NumFilledBlocks(0),
+NextBlock(0),
+CurrentBlockStartTime(0.0),
+bHasCurrentBlock(false),
+Offset(0.0),
+Drift(0.0),
+ReferenceTime(0.0),
+bHasEstimate(false),
+bRestarted(false)
+{
+}
+
+void FVRPNClockSync::AddSample(const timeval &ServerTime, double LocalReceiveTime)
+{
+	const double ServerSeconds = ToSeconds(ServerTime);
+	if(ServerSeconds <= 0.0)
+	{
+		// Reports that did not come from a server (e.g. replicated in a cluster) have no time
+		return;
+	}
+
+	const double SampleOffset = LocalReceiveTime - ServerSeconds;
+	if(bHasEstimate && GetOffset() - SampleOffset > MaxOffsetJump)
+	{
+		// The server clock jumped forward
+		Restart();
+	}
+
+	if(!bHasCurrentBlock)
+	{
+		CurrentMinimum = {LocalReceiveTime, SampleOffset};
+		CurrentBlockStartTime = LocalReceiveTime;
+		bHasCurrentBlock = true;
+	}
+	else if(SampleOffset < CurrentMinimum.Offset)
+	{
+		CurrentMinimum = {LocalReceiveTime, SampleOffset};
+	}
+
+	if(LocalReceiveTime - CurrentBlockStartTime >= BlockDuration)
+	{
+		if(bHasEstimate && CurrentMinimum.Offset - GetOffset() > MaxOffsetJump)
+		{
+			// The server clock jumped back, not a single sample in this block was close to the estimate
+			const OffsetSample NewMinimum = CurrentMinimum;
+			Restart();
+			CurrentMinimum = NewMinimum;
+		}
+		Blocks[NextBlock] = CurrentMinimum;
+		NextBlock = (NextBlock + 1) % NumBlocks;
+		NumFilledBlocks = FMath::Min(NumFilledBlocks + 1, NumBlocks);
+		bHasCurrentBlock = false;
+		FitBlocks();
+	}
+	else if(NumFilledBlocks == 0)
+	{
+		// Until the first block is done use the best sample so far
+		Offset = CurrentMinimum.Offset;
+		ReferenceTime = CurrentMinimum.LocalTime;
+		Drift = 0.0;
+		bHasEstimate = true;
+	}
+}
+
+void FVRPNClockSync::Restart()
+{
+	// This runs in the callbacks, the device logs it on the game thread
+	bRestarted = true;
+	NumFilledBlocks = 0;
+	NextBlock = 0;
+	bHasCurrentBlock = false;
+	bHasEstimate = false;
+}
+
+void FVRPNClockSync::FitBlocks()
+{
+	double MeanTime = 0.0;
+	double MeanOffset = 0.0;
+	for(int32 i = 0; i < NumFilledBlocks; ++i)
+	{
+		MeanTime += Blocks[i].LocalTime;
+		MeanOffset += Blocks[i].Offset;
+	}
+	MeanTime /= NumFilledBlocks;
+	MeanOffset /= NumFilledBlocks;
+
+	double Covariance = 0.0;
+	double Variance = 0.0;
+	for(int32 i = 0; i < NumFilledBlocks; ++i)
+	{
+		const double DeltaTime = Blocks[i].LocalTime - MeanTime;
+		Covariance += DeltaTime * (Blocks[i].Offset - MeanOffset);
+		Variance += DeltaTime * DeltaTime;
+	}
+
+	Offset = MeanOffset;
+	ReferenceTime = MeanTime;
+	Drift = Variance > 0.0 ? Covariance / Variance : 0.0;
+	bHasEstimate = true;
+}
+
+double FVRPNClockSync::GetOffset() const
+{
+	return Offset + Drift * (FPlatformTime::Seconds() - ReferenceTime);
+}
+
+double FVRPNClockSync::ServerToLocalTime(const timeval &ServerTime) const
+{
+	const double ServerSeconds = ToSeconds(ServerTime);
+	if(!bHasEstimate || ServerSeconds <= 0.0)
+	{
+		return 0.0;
+	}
+	// The local time is needed to evaluate the drift, the offset without drift is close enough for that
+	const double ApproximateLocalTime = ServerSeconds + Offset;
+	return ServerSeconds + Offset + Drift * (ApproximateLocalTime - ReferenceTime);
+}
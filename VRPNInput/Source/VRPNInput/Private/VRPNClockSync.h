@@ -0,0 +1,114 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#if PLATFORM_WINDOWS
+	#include "AllowWindowsPlatformTypes.h"
+		#include "vrpn_Shared.h"
+	#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+	#include "vrpn_Shared.h"
+#endif
+
+/*
+ * Estimates the offset and drift between the clock of a VRPN server and the local clock (FPlatformTime::Seconds()),
+ * so the msg_time of a report can be converted to local time.
+ *
+ * Every report gives a sample of (local receive time - server time), which is the clock offset plus the network delay.
+ * For each block of a second only the sample with the smallest difference is kept, that is the one with the least delay.
+ * A line is fitted through the last blocks, its slope is the drift of the server clock.
+ * This is a one-way estimate, there is no round trip to the server to measure the network delay.
+ * The estimated offset therefore still contains the smallest one-way network delay, and the receive ages that are
+ * computed with it leave out the same amount. On a local network this is well below a millisecond.
+ * A round trip would need a server that echoes a message back, which the standard VRPN servers do not do.
+ */
+class FVRPNClockSync
+{
+public:
+	FVRPNClockSync();
+
+	/* Adds the server time of a report that was received at local time LocalReceiveTime. */
+	void AddSample(const timeval &ServerTime, double LocalReceiveTime);
+
+	/* Converts a server time to local time. Returns zero when there are no samples or the server does not set the time. */
+	double ServerToLocalTime(const timeval &ServerTime) const;
+
+	bool IsValid() const { return bHasEstimate; }
+	// Local time minus server time in seconds, at the current local time
+	double GetOffset() const;
+	// Drift of the server clock relative to the local clock, in seconds per second
+	double GetDrift() const { return Drift; }
+	// True once after the estimate was restarted because the server clock changed, so it can be logged outside the callbacks
+	bool ConsumeRestart() { const bool bWasRestarted = bRestarted; bRestarted = false; return bWasRestarted; }
+
+private:
+	void FitBlocks();
+	void Restart();
+
+	struct OffsetSample
+	{
+		double LocalTime;
+		double Offset;
+	};
+
+	static const int32 NumBlocks = 16;
+	OffsetSample Blocks[NumBlocks];
+	int32 NumFilledBlocks;
+	int32 NextBlock;
+
+	// Smallest offset in the block that is being filled
+	OffsetSample CurrentMinimum;
+	double CurrentBlockStartTime;
+	bool bHasCurrentBlock;
+
+	// Offset(t) = Offset + Drift * (t - ReferenceTime)
+	double Offset;
+	double Drift;
+	double ReferenceTime;
+	bool bHasEstimate;
+	bool bRestarted;
+};
+
+/*
+ * Keeps track of the receive age of the samples: the time from the server time stamp (converted with FVRPNClockSync)
+ * to the moment the sample is send to the engine. This is not the end-to-end latency, the one-way network delay is left out.
+ */
+struct FVRPNReceiveAgeStats
+{
+	FVRPNReceiveAgeStats() : NumSamples(0), TotalAge(0.0), MaxAge(0.0) {}
+
+	void AddSample(double Age)
+	{
+		++NumSamples;
+		TotalAge += Age;
+		MaxAge = FMath::Max(MaxAge, Age);
+	}
+	double GetMeanAge() const { return NumSamples > 0 ? TotalAge / NumSamples : 0.0; }
+	void Reset() { *this = FVRPNReceiveAgeStats(); }
+
+	int64 NumSamples;
+	double TotalAge;
+	double MaxAge;
+};
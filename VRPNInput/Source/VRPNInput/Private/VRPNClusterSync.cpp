@@ -0,0 +1,249 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNClusterSync.h"
+#include "Networking.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace
+{
+	const uint32 SnapshotMagic = 0x4E505256; // "VRPN"
+	const uint32 SnapshotVersion = 3;
+	// Magic, version, frame number, number of devices, payload size and payload CRC
+	const int32 SnapshotHeaderSize = 6 * sizeof(uint32);
+	// Largest payload that fits in a single UDP datagram
+	const int32 MaxSnapshotSize = 65507;
+	// A replica accepts an older frame number if it is this far behind, the primary was restarted in that case
+	const int32 MaxFrameRewind = 1000;
+}
+
+FVRPNClusterSync* FVRPNClusterSync::CreateFromCommandLine()
+{
+	FString RoleString;
+	if(!FParse::Value(FCommandLine::Get(), TEXT("VRPNClusterRole="), RoleString))
+	{
+		return nullptr;
+	}
+
+	ERole Role;
+	if(RoleString.Equals(TEXT("Primary")))
+	{
+		Role = ERole::Primary;
+	}
+	else if(RoleString.Equals(TEXT("Replica")))
+	{
+		Role = ERole::Replica;
+	}
+	else
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("VRPNClusterRole should be Primary or Replica but found %s. Cluster mode is disabled."), *RoleString);
+		return nullptr;
+	}
+
+	FString AddressString;
+	FIPv4Endpoint ClusterEndpoint;
+	if(!FParse::Value(FCommandLine::Get(), TEXT("VRPNClusterAddress="), AddressString) || !FIPv4Endpoint::Parse(AddressString, ClusterEndpoint))
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Expected VRPNClusterAddress=ip:port when VRPNClusterRole is given. Cluster mode is disabled."));
+		return nullptr;
+	}
+
+	FSocket *Socket = nullptr;
+	if(Role == ERole::Primary)
+	{
+		Socket = FUdpSocketBuilder(TEXT("VRPNClusterPrimary"))
+			.AsNonBlocking()
+			.AsReusable()
+			.WithMulticastLoopback()
+			.WithMulticastTtl(1)
+			.WithSendBufferSize(MaxSnapshotSize);
+	}
+	else
+	{
+		FUdpSocketBuilder Builder = FUdpSocketBuilder(TEXT("VRPNClusterReplica"))
+			.AsNonBlocking()
+			.AsReusable()
+			.BoundToEndpoint(FIPv4Endpoint(FIPv4Address::Any, ClusterEndpoint.Port))
+			.WithMulticastLoopback()
+			.WithReceiveBufferSize(4 * MaxSnapshotSize);
+		if(ClusterEndpoint.Address.IsMulticastAddress())
+		{
+			Builder.JoinedToGroup(ClusterEndpoint.Address);
+		}
+		Socket = Builder;
+	}
+
+	if(Socket == nullptr)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not create the VRPN cluster socket for %s. Cluster mode is disabled."), *AddressString);
+		return nullptr;
+	}
+
+	UE_LOG(LogVRPNInputDevice, Log, TEXT("VRPN cluster mode: %s on %s."), *RoleString, *AddressString);
+	return new FVRPNClusterSync(Role, Socket, ClusterEndpoint.ToInternetAddr());
+}
+
+FVRPNClusterSync::FVRPNClusterSync(ERole InRole):
+FVRPNClusterSync(InRole, nullptr, nullptr)
+{
+}
+
+FVRPNClusterSync::FVRPNClusterSync(ERole InRole, FSocket *InSocket, TSharedPtr<FInternetAddr> InClusterAddress):
+Role(InRole),
+Socket(InSocket),
+ClusterAddress(InClusterAddress),
+FrameNumber(0),
+bReceivedSnapshot(false)
+{
+	Buffer.Reserve(MaxSnapshotSize);
+}
+
+FVRPNClusterSync::~FVRPNClusterSync()
+{
+	if(Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+}
+
+const TArray<uint8>& FVRPNClusterSync::WriteSnapshot(const TArray<IVRPNInputDevice*> &Devices)
+{
+	++FrameNumber;
+
+	Buffer.Reset();
+	FMemoryWriter Writer(Buffer);
+	uint32 Magic = SnapshotMagic;
+	uint32 Version = SnapshotVersion;
+	int32 NumDevices = Devices.Num();
+	uint32 PayloadSize = 0;
+	uint32 PayloadCrc = 0;
+	Writer << Magic << Version << FrameNumber << NumDevices << PayloadSize << PayloadCrc;
+	for(IVRPNInputDevice *Device : Devices)
+	{
+		Device->SerializeClusterState(Writer);
+	}
+
+	// The replicas only apply a snapshot that arrived whole, a device that is applied from a half snapshot could see a false button edge
+	PayloadSize = Buffer.Num() - SnapshotHeaderSize;
+	PayloadCrc = FCrc::MemCrc32(Buffer.GetData() + SnapshotHeaderSize, PayloadSize);
+	Writer.Seek(SnapshotHeaderSize - 2 * sizeof(uint32));
+	Writer << PayloadSize << PayloadCrc;
+	return Buffer;
+}
+
+void FVRPNClusterSync::SendState(const TArray<IVRPNInputDevice*> &Devices)
+{
+	WriteSnapshot(Devices);
+	if(Socket == nullptr)
+	{
+		return;
+	}
+
+	if(Buffer.Num() > MaxSnapshotSize)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("VRPN cluster snapshot is %i bytes which does not fit in a single datagram. Frame %u is not sent."), Buffer.Num(), FrameNumber);
+		return;
+	}
+
+	int32 BytesSent = 0;
+	Socket->SendTo(Buffer.GetData(), Buffer.Num(), BytesSent, *ClusterAddress);
+}
+
+void FVRPNClusterSync::ReceiveState(const TArray<IVRPNInputDevice*> &Devices)
+{
+	// Apply every snapshot in order, the trackers end up at the newest sample
+	// and button presses that only lasted a single primary frame are not lost.
+	uint32 PendingDataSize = 0;
+	while(Socket->HasPendingData(PendingDataSize))
+	{
+		Buffer.SetNumUninitialized(MaxSnapshotSize, /*bAllowShrinking=*/false);
+		int32 BytesRead = 0;
+		if(!Socket->Recv(Buffer.GetData(), Buffer.Num(), BytesRead) || BytesRead <= 0)
+		{
+			break;
+		}
+		ApplyBuffer(Devices, BytesRead);
+	}
+}
+
+bool FVRPNClusterSync::ApplySnapshot(const TArray<IVRPNInputDevice*> &Devices, const TArray<uint8> &Snapshot)
+{
+	// The buffer keeps its capacity, so this does not allocate
+	Buffer.Reset();
+	Buffer.Append(Snapshot);
+	return ApplyBuffer(Devices, Snapshot.Num());
+}
+
+bool FVRPNClusterSync::ApplyBuffer(const TArray<IVRPNInputDevice*> &Devices, int32 NumBytes)
+{
+	Buffer.SetNum(NumBytes, /*bAllowShrinking=*/false);
+	FMemoryReader Reader(Buffer);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 SnapshotFrame = 0;
+	int32 NumDevices = 0;
+	uint32 PayloadSize = 0;
+	uint32 PayloadCrc = 0;
+	Reader << Magic << Version << SnapshotFrame << NumDevices << PayloadSize << PayloadCrc;
+	if(Reader.IsError() || Magic != SnapshotMagic || Version != SnapshotVersion)
+	{
+		return false;
+	}
+	// Checked before any device is touched, the devices are then either all applied or not at all
+	if(PayloadSize != static_cast<uint32>(NumBytes - SnapshotHeaderSize) || FCrc::MemCrc32(Buffer.GetData() + SnapshotHeaderSize, PayloadSize) != PayloadCrc)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("VRPN cluster snapshot for frame %u is truncated or corrupt (%i of %u bytes), it is ignored."), SnapshotFrame, NumBytes - SnapshotHeaderSize, PayloadSize);
+		return false;
+	}
+	if(NumDevices != Devices.Num())
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("VRPN cluster snapshot has %i devices but this node has %i. Make sure all nodes use the same VRPN config file."), NumDevices, Devices.Num());
+		return false;
+	}
+
+	// Drop datagrams that arrive out of order
+	const int32 FrameDelta = static_cast<int32>(SnapshotFrame - FrameNumber);
+	if(bReceivedSnapshot && FrameDelta <= 0 && FrameDelta > -MaxFrameRewind)
+	{
+		return false;
+	}
+
+	for(IVRPNInputDevice *Device : Devices)
+	{
+		Device->SerializeClusterState(Reader);
+	}
+	if(Reader.IsError())
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not read VRPN cluster snapshot for frame %u."), SnapshotFrame);
+		return false;
+	}
+
+	FrameNumber = SnapshotFrame;
+	bReceivedSnapshot = true;
+	return true;
+}
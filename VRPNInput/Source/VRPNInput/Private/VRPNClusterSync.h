@@ -0,0 +1,93 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNInputDevice.h"
+
+class FSocket;
+class FInternetAddr;
+
+/*
+ * Distributes the VRPN state over a cluster of render nodes (e.g. the walls of a cave).
+ * Only the primary node connects to the VRPN servers. Each frame it sends a frame numbered snapshot
+ * of all devices over UDP (multicast), the replica nodes apply these snapshots instead of polling VRPN.
+ * This way every node sees the same samples and the VRPN servers only have a single client.
+ *
+ * The role is given on the command line:
+ *   -VRPNClusterRole=Primary|Replica -VRPNClusterAddress=239.255.42.99:6666
+ * Multicast loopback is enabled so the primary and several replicas can run on the same machine.
+ */
+class FVRPNClusterSync
+{
+public:
+	enum class ERole
+	{
+		Primary,
+		Replica
+	};
+
+	/* Returns nullptr if the command line does not specify a cluster role. */
+	static FVRPNClusterSync* CreateFromCommandLine();
+
+	/* Creates a cluster sync without a socket, the snapshots are then only passed with WriteSnapshot() and ApplySnapshot(). Used by the tests. */
+	explicit FVRPNClusterSync(ERole InRole);
+
+	~FVRPNClusterSync();
+
+	ERole GetRole() const { return Role; }
+
+	/* Sends the state of all devices to the replicas, call this on the primary after the devices are updated. */
+	void SendState(const TArray<IVRPNInputDevice*> &Devices);
+
+	/* Applies all snapshots that arrived since the last call, call this on a replica before the devices are updated. */
+	void ReceiveState(const TArray<IVRPNInputDevice*> &Devices);
+
+	/* Writes the snapshot of the next frame, this is what SendState() sends. The buffer is reused by the next call. */
+	const TArray<uint8>& WriteSnapshot(const TArray<IVRPNInputDevice*> &Devices);
+
+	/*
+	 * Applies a snapshot written by WriteSnapshot(). Returns false, and leaves every device as it was, when the snapshot
+	 * is truncated or corrupt, older than the last applied one or for a different configuration.
+	 */
+	bool ApplySnapshot(const TArray<IVRPNInputDevice*> &Devices, const TArray<uint8> &Snapshot);
+
+private:
+	FVRPNClusterSync(ERole InRole, FSocket *InSocket, TSharedPtr<FInternetAddr> InClusterAddress);
+
+	// Applies the first NumBytes of Buffer
+	bool ApplyBuffer(const TArray<IVRPNInputDevice*> &Devices, int32 NumBytes);
+
+	ERole Role;
+	// Both are null for a cluster sync without a socket
+	FSocket *Socket;
+	TSharedPtr<FInternetAddr> ClusterAddress;
+
+	// Frame number of the last snapshot that was sent (primary) or applied (replica)
+	uint32 FrameNumber;
+	bool bReceivedSnapshot;
+
+	// Reused every frame so sending and receiving does not allocate
+	TArray<uint8> Buffer;
+};
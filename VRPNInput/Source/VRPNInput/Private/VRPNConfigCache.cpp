@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNConfigCache.h"
+
+FVRPNConfigCache::FVRPNConfigCache(const FString &InConfigFile):
+ConfigFile(InConfigFile),
+ConfigCrc(0),
+bHasConfig(false)
+{
+	TArray<uint8> ConfigContents;
+	if(FFileHelper::LoadFileToArray(ConfigContents, *ConfigFile))
+	{
+		ConfigCrc = FCrc::MemCrc32(ConfigContents.GetData(), ConfigContents.Num());
+		bHasConfig = true;
+	}
+}
+
+bool FVRPNConfigCache::Load(const FCreateDeviceFunction &CreateDevice, TArray<ConfiguredDevice> &OutDevices) const
+{
+	return bHasConfig && LoadFile(GetCacheFile(), CreateDevice, OutDevices);
+}
+
+bool FVRPNConfigCache::LoadFile(const FString &CacheFile, const FCreateDeviceFunction &CreateDevice, TArray<ConfiguredDevice> &OutDevices) const
+{
+	TArray<uint8> Buffer;
+	if(!FPaths::FileExists(CacheFile) || !FFileHelper::LoadFileToArray(Buffer, *CacheFile) || Buffer.Num() < HeaderSize)
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Buffer);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 CachedConfigCrc = 0;
+	uint32 PayloadCrc = 0;
+	int32 PayloadSize = 0;
+	Reader << Magic << Version << CachedConfigCrc << PayloadCrc << PayloadSize;
+	if(Magic != CacheMagic || Version != CacheVersion || CachedConfigCrc != ConfigCrc || PayloadSize != Buffer.Num() - HeaderSize ||
+	   PayloadCrc != FCrc::MemCrc32(Buffer.GetData() + HeaderSize, PayloadSize))
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("VRPN config cache %s is out of date."), *CacheFile);
+		return false;
+	}
+
+	int32 NumDevices = 0;
+	Reader << NumDevices;
+	for(int32 DeviceIndex = 0; DeviceIndex < NumDevices && !Reader.IsError(); ++DeviceIndex)
+	{
+		FString SectionName;
+		ConfiguredDevice Entry;
+		Reader << SectionName << Entry.Type << Entry.Address;
+		Entry.Device = Reader.IsError() ? nullptr : CreateDevice(Entry.Type, SectionName, Entry.Address);
+		if(Entry.Device == nullptr)
+		{
+			Reader.SetError();
+			break;
+		}
+		Entry.Device->SerializeConfig(Reader);
+		OutDevices.Add(Entry);
+	}
+
+	if(Reader.IsError())
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not read VRPN config cache %s."), *CacheFile);
+		for(ConfiguredDevice &Entry : OutDevices)
+		{
+			delete Entry.Device;
+		}
+		OutDevices.Empty();
+		return false;
+	}
+	return true;
+}
+
+void FVRPNConfigCache::Save(const TArray<ConfiguredDevice> &Devices) const
+{
+	if(!bHasConfig)
+	{
+		return;
+	}
+
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+	int32 NumDevices = Devices.Num();
+	PayloadWriter << NumDevices;
+	for(const ConfiguredDevice &Entry : Devices)
+	{
+		FString SectionName = Entry.Device->GetDeviceName();
+		FString Type = Entry.Type;
+		FString Address = Entry.Address;
+		PayloadWriter << SectionName << Type << Address;
+		Entry.Device->SerializeConfig(PayloadWriter);
+	}
+
+	TArray<uint8> Buffer;
+	Buffer.Reserve(HeaderSize + Payload.Num());
+	FMemoryWriter Writer(Buffer);
+	uint32 Magic = CacheMagic;
+	uint32 Version = CacheVersion;
+	uint32 CachedConfigCrc = ConfigCrc;
+	uint32 PayloadCrc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+	int32 PayloadSize = Payload.Num();
+	Writer << Magic << Version << CachedConfigCrc << PayloadCrc << PayloadSize;
+	Writer.Serialize(Payload.GetData(), Payload.Num());
+
+	const FString CacheFile = GetCacheFile();
+	if(FFileHelper::SaveArrayToFile(Buffer, *CacheFile))
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Wrote VRPN config cache %s."), *CacheFile);
+	}
+	else
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not write the VRPN config cache %s for %s."), *CacheFile, *ConfigFile);
+	}
+}
+
+FString FVRPNConfigCache::GetCacheFile() const
+{
+	// Config files with the same name in different directories share the Saved directory, so the name includes a hash of the path
+	const uint32 PathCrc = FCrc::StrCrc32(*FPaths::ConvertRelativePathToFull(ConfigFile));
+	return FPaths::GameSavedDir() / TEXT("VRPNInput") / FString::Printf(TEXT("%s-%08X.vrpncache"), *FPaths::GetBaseFilename(ConfigFile), PathCrc);
+}
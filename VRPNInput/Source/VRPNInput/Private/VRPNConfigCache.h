@@ -0,0 +1,78 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNInputDevice.h"
+
+/*
+ * Binary cache of the parsed VRPN config, so large configs do not have to be parsed on every start.
+ * The cache is written to Saved/VRPNInput and not next to the config file, where it could end up in a package or in source control.
+ * The file name has a hash of the config path, so configs with the same name in different directories do not share a cache.
+ * It stores the CRC of the config file contents and is only used when that still matches, so any edit of the config file
+ * makes the plugin parse it again. Use -VRPNNoConfigCache to always parse the config file.
+ *
+ * Layout: magic, version, config CRC, payload CRC and payload size, followed by the payload with the number of devices and
+ * for each device the section name, type and address followed by IVRPNInputDevice::SerializeConfig.
+ */
+class FVRPNConfigCache
+{
+public:
+	struct ConfiguredDevice
+	{
+		IVRPNInputDevice *Device;
+		FString Type;
+		FString Address;
+	};
+
+	// Creates an empty device for a section, returns nullptr when the type is unknown
+	typedef TFunction<IVRPNInputDevice*(const FString &Type, const FString &SectionName, const FString &Address)> FCreateDeviceFunction;
+
+	FVRPNConfigCache(const FString &InConfigFile);
+
+	/*
+	 * Creates the devices from the cache. Returns false and creates no devices when there is no valid cache.
+	 */
+	bool Load(const FCreateDeviceFunction &CreateDevice, TArray<ConfiguredDevice> &OutDevices) const;
+
+	/*
+	 * Writes the cache, call this after the devices are created from the config file and before their keys are registered.
+	 */
+	void Save(const TArray<ConfiguredDevice> &Devices) const;
+
+	// Saved/VRPNInput/<config name>-<hash of the config path>.vrpncache
+	FString GetCacheFile() const;
+
+private:
+	bool LoadFile(const FString &CacheFile, const FCreateDeviceFunction &CreateDevice, TArray<ConfiguredDevice> &OutDevices) const;
+
+	static const uint32 CacheMagic = 0x43505256; // "VRPC"
+	// Increase this when a SerializeConfig function changes
+	static const uint32 CacheVersion = 3;
+	static const int32 HeaderSize = 5 * sizeof(uint32);
+
+	FString ConfigFile;
+	uint32 ConfigCrc;
+	bool bHasConfig;
+};
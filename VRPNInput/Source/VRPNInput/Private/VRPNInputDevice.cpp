@@ -24,15 +24,301 @@ SOFTWARE.
 
 #include "VRPNInputPrivatePCH.h"
 #include "VRPNInputDevice.h"
+#include "VRPNMotionController.h"
+#include "VRPNSimulatedSource.h"
+
+namespace
+{
+	timeval SampleTimeToTimeval(double Time)
+	{
+		timeval Result;
+		Result.tv_sec = static_cast<long>(Time);
+		Result.tv_usec = static_cast<long>((Time - FMath::FloorToDouble(Time)) * 1000000.0);
+		return Result;
+	}
+
+	// FPlatformAtomics has no atomic and/or for 64 bit values, so these use a compare and exchange loop
+	void AtomicOr(volatile int64 *Value, int64 Bits)
+	{
+		int64 OldValue;
+		do
+		{
+			OldValue = *Value;
+		} while(FPlatformAtomics::InterlockedCompareExchange(Value, OldValue | Bits, OldValue) != OldValue);
+	}
+
+	void AtomicAnd(volatile int64 *Value, int64 Bits)
+	{
+		int64 OldValue;
+		do
+		{
+			OldValue = *Value;
+		} while(FPlatformAtomics::InterlockedCompareExchange(Value, OldValue & Bits, OldValue) != OldValue);
+	}
+}
+
+//--------------------------------DEVICE-----------------------------
+
+IVRPNEventSink *IVRPNInputDevice::EventSink = nullptr;
+
+FModifierKeysState IVRPNInputDevice::GetModifierKeys() {
+	return EventSink ? FModifierKeysState() : FSlateApplication::Get().GetModifierKeys();
+}
+
+void IVRPNInputDevice::SendKeyEvent(const FKey &Key, bool bPressed, const FModifierKeysState &ModifierKeys) {
+	if(EventSink)
+	{
+		EventSink->SendKey(Key, bPressed, ModifierKeys);
+		return;
+	}
+	FKeyEvent KeyEvent(Key, ModifierKeys, 0, 0, 0, 0);
+	if(bPressed)
+	{
+		FSlateApplication::Get().ProcessKeyDownEvent(KeyEvent);
+	}
+	else
+	{
+		FSlateApplication::Get().ProcessKeyUpEvent(KeyEvent);
+	}
+}
+
+void IVRPNInputDevice::SendAxisEvent(const FKey &Key, float Value, const FModifierKeysState &ModifierKeys) {
+	if(EventSink)
+	{
+		EventSink->SendAxis(Key, Value, ModifierKeys);
+		return;
+	}
+	FAnalogInputEvent AnalogInputEvent(Key, ModifierKeys, 0, 0, 0, 0, Value);
+	FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEvent);
+}
+
+void IVRPNInputDevice::ParseSchedulingConfig(FConfigSection *InConfigSection) {
+	FConfigValue *UpdateRateConfigValue = InConfigSection->Find(FName(TEXT("UpdateRateHz")));
+	if(UpdateRateConfigValue)
+	{
+		const float UpdateRate = FCString::Atof(*UpdateRateConfigValue->GetValue());
+		UpdateInterval = UpdateRate > 0.0f ? 1.0 / UpdateRate : 0.0;
+	}
+
+	FConfigValue *PriorityConfigValue = InConfigSection->Find(FName(TEXT("Priority")));
+	if(PriorityConfigValue)
+	{
+		const FString &PriorityString = PriorityConfigValue->GetValue();
+		if(PriorityString.Equals("High"))
+		{
+			Priority = EVRPNDevicePriority::High;
+		}
+		else if(PriorityString.Equals("Normal"))
+		{
+			Priority = EVRPNDevicePriority::Normal;
+		}
+		else if(PriorityString.Equals("Low"))
+		{
+			Priority = EVRPNDevicePriority::Low;
+		}
+		else
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Priority should be High, Normal or Low but found %s. Using the default priority."), *PriorityString);
+		}
+	}
+
+	FConfigValue *MaxEventsConfigValue = InConfigSection->Find(FName(TEXT("MaxEventsPerTick")));
+	if(MaxEventsConfigValue)
+	{
+		MaxEventsPerTick = FMath::Max(FCString::Atoi(*MaxEventsConfigValue->GetValue()), 0);
+	}
+}
+
+void IVRPNInputDevice::SerializeConfig(FArchive &Ar) {
+	uint8 PriorityValue = static_cast<uint8>(Priority);
+	Ar << PriorityValue << UpdateInterval << MaxEventsPerTick;
+	Priority = static_cast<EVRPNDevicePriority>(PriorityValue);
+
+	int32 NumKeys = KeyDetails.Num();
+	Ar << NumKeys;
+	if(Ar.IsLoading())
+	{
+		KeyDetails.Reset(NumKeys);
+	}
+	for(int32 KeyIndex = 0; KeyIndex < NumKeys && !Ar.IsError(); ++KeyIndex)
+	{
+		FName KeyName;
+		FString DisplayName;
+		uint8 KeyFlags = 0;
+		if(Ar.IsSaving())
+		{
+			const FKeyDetails &Details = KeyDetails[KeyIndex];
+			KeyName = Details.GetKey().GetFName();
+			DisplayName = Details.GetDisplayName().ToString();
+			// These are the only flags the devices use
+			KeyFlags = (Details.IsGamepadKey() ? FKeyDetails::GamepadKey : 0) | (Details.IsFloatAxis() ? FKeyDetails::FloatAxis : 0);
+		}
+		Ar << KeyName << DisplayName << KeyFlags;
+		if(Ar.IsLoading())
+		{
+			KeyDetails.Add(FKeyDetails(FKey(KeyName), FText::FromString(DisplayName), KeyFlags));
+		}
+	}
+
+	SerializeDeviceConfig(Ar);
+}
+
+int32 IVRPNInputDevice::RegisterKeys() {
+	const int32 NumKeys = KeyDetails.Num();
+	for(const FKeyDetails &Details : KeyDetails)
+	{
+		EKeys::AddKey(Details);
+	}
+	KeyDetails.Empty();
+	return NumKeys;
+}
+
+void IVRPNInputDevice::DumpReceiveAgeStats(FOutputDevice &Ar) {
+	double ClockOffset;
+	double ClockDrift;
+	bool bClockValid;
+	{
+		FScopeLock StateLock(&StateCritSect);
+		bClockValid = ClockSync.IsValid();
+		ClockOffset = ClockSync.GetOffset();
+		ClockDrift = ClockSync.GetDrift();
+	}
+
+	if(bClockValid)
+	{
+		Ar.Logf(TEXT("%s: clock offset %.6f s, drift %.2f ppm, %lld samples, receive age mean %.3f ms max %.3f ms"), *DeviceName,
+			ClockOffset, ClockDrift * 1000000.0, ReceiveAgeStats.NumSamples, ReceiveAgeStats.GetMeanAge() * 1000.0, ReceiveAgeStats.MaxAge * 1000.0);
+	}
+	else
+	{
+		Ar.Logf(TEXT("%s: no time stamped samples"), *DeviceName);
+	}
+	ReceiveAgeStats.Reset();
+}
+
+IVRPNInputDevice::DeviceStats IVRPNInputDevice::GetStats() const {
+	FScopeLock StateLock(&StateCritSect);
+	return Stats;
+}
+
+int64 IVRPNInputDevice::DumpStats(FOutputDevice &Ar, double ElapsedSeconds) {
+	DeviceStats CurrentStats;
+	{
+		FScopeLock StateLock(&StateCritSect);
+		CurrentStats = Stats;
+		Stats.NumReports = 0;
+		Stats.MaxQueueDepth = 0;
+	}
+	Stats.NumEvents = 0;
+	Stats.NumUpdates = 0;
+	Stats.TotalUpdateTime = 0.0;
+	Stats.MaxUpdateTime = 0.0;
+
+	const int64 NumLostSamples = SampleSource ? SampleSource->GetNumLostSamples() : 0;
+	const int64 NumDroppedEvents = GetNumDroppedEvents();
+	const int64 NumNewLosses = NumLostSamples + NumDroppedEvents - NumReportedLosses;
+	NumReportedLosses = NumLostSamples + NumDroppedEvents;
+
+	const double Seconds = FMath::Max(ElapsedSeconds, SMALL_NUMBER);
+	// The most reports per second this device could handle if updating it was all the game thread did
+	const double ReportCeiling = CurrentStats.TotalUpdateTime > 0.0 ? CurrentStats.NumReports / CurrentStats.TotalUpdateTime : 0.0;
+	const double MeanUpdateTime = CurrentStats.NumUpdates > 0 ? CurrentStats.TotalUpdateTime / CurrentStats.NumUpdates : 0.0;
+	Ar.Logf(TEXT("%s: %.0f reports/s, %.0f events/s, ceiling %.0f reports/s, %lld lost samples, %lld dropped events, max queue depth %i, update mean %.3f ms max %.3f ms"), *DeviceName,
+		CurrentStats.NumReports / Seconds, CurrentStats.NumEvents / Seconds, ReportCeiling,
+		NumLostSamples, NumDroppedEvents, CurrentStats.MaxQueueDepth, MeanUpdateTime * 1000.0, CurrentStats.MaxUpdateTime * 1000.0);
+	return NumNewLosses;
+}
+
+void IVRPNInputDevice::AddUpdateTime(double Seconds) {
+	++Stats.NumUpdates;
+	Stats.TotalUpdateTime += Seconds;
+	Stats.MaxUpdateTime = FMath::Max(Stats.MaxUpdateTime, Seconds);
+
+	// The reports that arrived since the previous update waited for this one, a depth that keeps growing means the device can not keep up
+	bool bClockRestarted;
+	{
+		FScopeLock StateLock(&StateCritSect);
+		Stats.MaxQueueDepth = FMath::Max(Stats.MaxQueueDepth, Stats.NumQueuedReports);
+		Stats.NumQueuedReports = 0;
+		bClockRestarted = ClockSync.ConsumeRestart();
+	}
+	if(bClockRestarted)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("%s: VRPN server clock was changed, restarting clock synchronization."), *DeviceName);
+	}
+}
+
+IVRPNSampleSource* IVRPNInputDevice::CreateSampleSource(const FString &Address, EVRPNSharedMemorySampleType Type) {
+	if(FVRPNSharedMemoryReader::IsSharedMemoryAddress(Address))
+	{
+		return new FVRPNSharedMemoryReader(Address);
+	}
+	if(FVRPNSimulatedSource::IsSimulatedAddress(Address))
+	{
+		return new FVRPNSimulatedSource(Address, Type);
+	}
+	return nullptr;
+}
+
+bool IVRPNInputDevice::IsSampleSourceAddress(const FString &Address) {
+	return FVRPNSharedMemoryReader::IsSharedMemoryAddress(Address) || FVRPNSimulatedSource::IsSimulatedAddress(Address);
+}
+
+float IVRPNInputDevice::GetPoseAxis(const FVector &Position, const FRotator &Rotation, int32 Axis) {
+	switch(Axis)
+	{
+	case 0: return Position.X;
+	case 1: return Position.Y;
+	case 2: return Position.Z;
+	case 3: return Rotation.Yaw;
+	case 4: return Rotation.Pitch;
+	case 5: return Rotation.Roll;
+	default: return 0.0f;
+	}
+}
+
+const TCHAR* const IVRPNInputDevice::PoseAxisKeySuffixes[NumPoseAxes] = {TEXT("MotionX"), TEXT("MotionY"), TEXT("MotionZ"), TEXT("RotationYaw"), TEXT("RotationPitch"), TEXT("RotationRoll")};
+const TCHAR* const IVRPNInputDevice::PoseAxisDescriptions[NumPoseAxes] = {TEXT(" X position"), TEXT(" Y position"), TEXT(" Z position"), TEXT(" Yaw"), TEXT(" Pitch"), TEXT(" Roll")};
+
+bool IVRPNInputDevice::SetSlot(TArray<int32> &Slots, int32 Id, int32 Slot) {
+	if(Id < 0 || Id > MaxSensorId)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Sensor id %i is out of range, ids should be between 0 and %i."), Id, MaxSensorId);
+		return false;
+	}
+	if(Id >= Slots.Num())
+	{
+		const int32 OldNum = Slots.Num();
+		Slots.SetNumUninitialized(Id + 1);
+		for(int32 i = OldNum; i < Slots.Num(); ++i)
+		{
+			Slots[i] = INDEX_NONE;
+		}
+	}
+	Slots[Id] = Slot;
+	return true;
+}
+
+void IVRPNInputDevice::WarnUnknownSensor(const TCHAR *SensorType, int32 Id) {
+	if(!bWarnedUnknownSensor)
+	{
+		bWarnedUnknownSensor = true;
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not find %s with id %i in %s. Other unknown ids of this device are not reported."), SensorType, Id, *DeviceName);
+	}
+}
 
 //--------------------------------BUTTON-----------------------------
 
 VRPNButtonInputDevice::VRPNButtonInputDevice(const FString &TrackerAddress, FCriticalSection& InCritSect, bool bEnabled):
 IVRPNInputDevice(InCritSect),
-InputDevice(nullptr)
+bReceivedClusterState(false),
+NumDroppedEvents(0),
+InputDevice(nullptr),
+SampleTime(0.0)
 {
-	KeyPressStack.Reserve(16);
-	if(bEnabled){
+	if(bEnabled && IsSampleSourceAddress(TrackerAddress)){
+		SampleSource = CreateSampleSource(TrackerAddress, EVRPNSharedMemorySampleType::Button);
+	} else if(bEnabled){
 		InputDevice = new vrpn_Button_Remote(TCHAR_TO_UTF8(*TrackerAddress));
 		//InputDevice->shutup = true;
 		InputDevice->register_change_handler(this, &VRPNButtonInputDevice::HandleButtonDevice);
@@ -44,37 +330,104 @@ VRPNButtonInputDevice::~VRPNButtonInputDevice() {
 }
 
 void VRPNButtonInputDevice::Update() {
-	if(InputDevice){
+	if(InputDevice && !bPolledExternally){
+		FScopeLock ScopeLock(&CritSect);
+		InputDevice->mainloop();
+	} else if(SampleSource){
+		PollSampleSource();
+	}
+
+	const FModifierKeysState ModifierKeys = GetModifierKeys();
+	int32 NumEvents = 0;
+	for(int32 WordIndex = 0; WordIndex < ButtonWords.Num(); ++WordIndex)
+	{
+		ButtonWord &Word = ButtonWords[WordIndex];
+		// Take the latches before reading the state, a change in between is then seen again in the next update without a spurious edge
+		const uint64 PressLatch = FPlatformAtomics::InterlockedExchange(&Word.PressLatch, 0);
+		const uint64 ReleaseLatch = FPlatformAtomics::InterlockedExchange(&Word.ReleaseLatch, 0);
+		const uint64 Pressed = Word.Pressed;
+		const uint64 Dispatched = Word.Dispatched;
+
+		// The first edge leaves the dispatched state, a second edge follows when the button is already back (a short tap or release)
+		const uint64 FirstDowns = ~Dispatched & (PressLatch | Pressed);
+		const uint64 FirstUps = Dispatched & (ReleaseLatch | ~Pressed);
+		// Muted buttons follow the state without sending events
+		const uint64 Changed = (FirstDowns | FirstUps) & ~static_cast<uint64>(Word.Muted);
+		if(Changed == 0)
 		{
-			FScopeLock ScopeLock(&CritSect);
-			InputDevice->mainloop();
+			Word.Dispatched = static_cast<int64>(Pressed);
+			continue;
 		}
-		while(KeyPressStack.Num() > 0)
+
+		// Buttons that did not fit in MaxEventsPerTick, and buttons of which only the first of two edges fit
+		uint64 Deferred = 0;
+		uint64 Halfway = 0;
+		for(int32 Bit = 0; Bit < ButtonsPerWord; ++Bit)
 		{
-			KeyEventPair ButtonEvent = KeyPressStack.Pop(/*bAllowShrinking=*/false);
-			// process the button presses
-			const FKey* Key = ButtonMap.Find(ButtonEvent.Button);
-			if(Key == nullptr)
+			const uint64 Mask = uint64(1) << Bit;
+			if((Changed & Mask) == 0)
 			{
-				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not find button with id %i."), ButtonEvent.Button);
-				return;
+				continue;
 			}
-
-
-			if(ButtonEvent.State == 1)
+			if(MaxEventsPerTick > 0 && NumEvents >= MaxEventsPerTick)
 			{
-				FKeyEvent KeyEvent(*Key, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0);
-				FSlateApplication::Get().ProcessKeyDownEvent(KeyEvent);
+				Deferred |= Mask;
+				continue;
 			}
-			else
+			const int32 Slot = WordIndex * ButtonsPerWord + Bit;
+			const bool bFirstDown = (FirstDowns & Mask) != 0;
+			SendButtonEvent(Slot, bFirstDown, ModifierKeys);
+			++NumEvents;
+			int32 NumButtonEvents = 1;
+			int32 NumPendingEvents = 0;
+			if(bFirstDown != ((Pressed & Mask) != 0))
 			{
-				FKeyEvent KeyEvent(*Key, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0);
-				FSlateApplication::Get().ProcessKeyUpEvent(KeyEvent);
+				if(MaxEventsPerTick > 0 && NumEvents >= MaxEventsPerTick)
+				{
+					Halfway |= Mask;
+					NumPendingEvents = 1;
+				}
+				else
+				{
+					SendButtonEvent(Slot, !bFirstDown, ModifierKeys);
+					++NumEvents;
+					++NumButtonEvents;
+				}
 			}
+
+			// More edges than events means the button changed more than twice since the last update
+			const int32 NumEdges = ButtonEdgeCounts[Slot].Presses + ButtonEdgeCounts[Slot].Releases;
+			NumDroppedEvents += FMath::Max(NumEdges - HandledEdgeCounts[Slot] - NumButtonEvents - NumPendingEvents, 0);
+			HandledEdgeCounts[Slot] = NumEdges - NumPendingEvents;
+		}
+
+		// Deferred buttons keep their dispatched state and get their latches back for the next update.
+		// Halfway buttons are dispatched in the state after the first edge (the opposite of Pressed), the latch of the second edge is put back
+		// so it is still send when the button changes again before the next update.
+		Word.Dispatched = static_cast<int64>((Pressed & ~(Deferred | Halfway)) | (Dispatched & Deferred) | (~Pressed & Halfway));
+		if((Deferred | Halfway) != 0)
+		{
+			AtomicOr(&Word.PressLatch, static_cast<int64>((PressLatch & Deferred) | (Pressed & Halfway)));
+			AtomicOr(&Word.ReleaseLatch, static_cast<int64>((ReleaseLatch & Deferred) | (~Pressed & Halfway)));
+		}
+	}
+	Stats.NumEvents += NumEvents;
+
+	if(NumEvents > 0)
+	{
+		FScopeLock StateLock(&StateCritSect);
+		if(SampleTime > 0.0)
+		{
+			ReceiveAgeStats.AddSample(FMath::Max(FPlatformTime::Seconds() - SampleTime, 0.0));
+			SampleTime = 0.0;
 		}
 	}
 }
 
+void VRPNButtonInputDevice::SendButtonEvent(int32 Slot, bool bPressed, const FModifierKeysState &ModifierKeys) const {
+	SendKeyEvent(ButtonKeys[Slot], bPressed, ModifierKeys);
+}
+
 bool VRPNButtonInputDevice::ParseConfig(FConfigSection *InConfigSection) {
 	TArray<const FConfigValue*> Buttons;
 	InConfigSection->MultiFindPointer(FName(TEXT("Button")), Buttons);
@@ -84,29 +437,212 @@ bool VRPNButtonInputDevice::ParseConfig(FConfigSection *InConfigSection) {
 		return false;
 	}
 	
+	KeyDetails.Reserve(Buttons.Num());
 	for(const FConfigValue* ButtonString: Buttons)
 	{
+		const TCHAR *ButtonConfig = *ButtonString->GetValue();
 		int32 ButtonId;
 		FString ButtonName;
 		FString ButtonDescription;
-		if(!FParse::Value(*ButtonString->GetValue(), TEXT("Id="), ButtonId) ||
-		   !FParse::Value(*ButtonString->GetValue(), TEXT("Name="), ButtonName) ||
-		   !FParse::Value(*ButtonString->GetValue(), TEXT("Description="), ButtonDescription))
+		if(!FParse::Value(ButtonConfig, TEXT("Id="), ButtonId) ||
+		   !FParse::Value(ButtonConfig, TEXT("Name="), ButtonName) ||
+		   !FParse::Value(ButtonConfig, TEXT("Description="), ButtonDescription))
 		{
 			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config not parse button. Expected: Button = (Id=#,Name=String,Description=String)."));
 			continue;
 		}
-		// While NewKey is only valid for this iteration it will be copied in FKeyDetails below
-		const FKey &NewKey = ButtonMap.Add(ButtonId, FKey(*ButtonName));
-		EKeys::AddKey(FKeyDetails(NewKey, FText::FromString(ButtonDescription), FKeyDetails::GamepadKey));
+		const FKey NewKey(*ButtonName);
+		if(AddButton(ButtonId, NewKey))
+		{
+			KeyDetails.Add(FKeyDetails(NewKey, FText::FromString(ButtonDescription), FKeyDetails::GamepadKey));
+		}
+	}
+
+	return ButtonKeys.Num() > 0;
+}
+
+void VRPNButtonInputDevice::SerializeDeviceConfig(FArchive &Ar) {
+	int32 NumButtons = ButtonKeys.Num();
+	Ar << NumButtons;
+	for(int32 Slot = 0; Slot < NumButtons && !Ar.IsError(); ++Slot)
+	{
+		int32 ButtonId = Ar.IsSaving() ? ButtonIds[Slot] : 0;
+		FName KeyName = Ar.IsSaving() ? ButtonKeys[Slot].GetFName() : FName();
+		Ar << ButtonId << KeyName;
+		if(Ar.IsLoading())
+		{
+			AddButton(ButtonId, FKey(KeyName));
+		}
+	}
+}
+
+bool VRPNButtonInputDevice::AddButton(int32 ButtonId, const FKey &Key) {
+	int32 Slot = FindSlot(ButtonSlots, ButtonId);
+	if(Slot == INDEX_NONE)
+	{
+		Slot = ButtonKeys.Num();
+		if(!SetSlot(ButtonSlots, ButtonId, Slot))
+		{
+			return false;
+		}
+		ButtonKeys.AddDefaulted();
+		ButtonIds.Add(ButtonId);
+		ButtonEdgeCounts.AddZeroed();
+		HandledEdgeCounts.AddZeroed();
+		if(Slot / ButtonsPerWord >= ButtonWords.Num())
+		{
+			ButtonWords.AddZeroed();
+		}
+	}
+	ButtonKeys[Slot] = Key;
+	return true;
+}
+
+void VRPNButtonInputDevice::SerializeClusterState(FArchive &Ar) {
+	int32 NumStates = ButtonIds.Num();
+	Ar << NumStates;
+	if(Ar.IsLoading())
+	{
+		for(int32 i = 0; i < NumStates && !Ar.IsError(); ++i)
+		{
+			vrpn_int32 Button;
+			vrpn_int32 State;
+			int32 Presses;
+			int32 Releases;
+			Ar << Button << State << Presses << Releases;
+			const int32 Slot = FindSlot(ButtonSlots, Button);
+			if(Slot == INDEX_NONE)
+			{
+				continue;
+			}
+			const bool bPressed = State != 0;
+			ButtonEdges &Edges = ButtonEdgeCounts[Slot];
+			if(bReceivedClusterState)
+			{
+				// The state is the same as before when the primary saw a press and release (or a release and press) within one frame,
+				// apply the opposite state first so the latches of this node give the same events
+				const bool bMissedEdge = bPressed ? Releases != Edges.Releases : Presses != Edges.Presses;
+				if(bMissedEdge)
+				{
+					SetButtonState(Slot, !bPressed);
+				}
+			}
+			SetButtonState(Slot, bPressed);
+			Edges.Presses = Presses;
+			Edges.Releases = Releases;
+			if(!bReceivedClusterState)
+			{
+				// The edges of the primary before this snapshot were not dropped here, only the press that was just applied gives an event
+				HandledEdgeCounts[Slot] = Presses + Releases - (bPressed ? 1 : 0);
+			}
+		}
+		bReceivedClusterState = true;
 	}
+	else
+	{
+		for(int32 Slot = 0; Slot < ButtonIds.Num(); ++Slot)
+		{
+			vrpn_int32 Button = ButtonIds[Slot];
+			vrpn_int32 State = IsSlotPressed(Slot) ? 1 : 0;
+			int32 Presses = ButtonEdgeCounts[Slot].Presses;
+			int32 Releases = ButtonEdgeCounts[Slot].Releases;
+			Ar << Button << State << Presses << Releases;
+		}
+	}
+}
+
+void VRPNButtonInputDevice::SetButtonState(int32 Slot, bool bPressed) {
+	ButtonWord &Word = ButtonWords[Slot / ButtonsPerWord];
+	const int64 Mask = int64(1) << (Slot % ButtonsPerWord);
+	// A repeated report does not change the state and does not set a latch
+	if(((Word.Pressed & Mask) != 0) == bPressed)
+	{
+		return;
+	}
+	// The edge is counted before the state is set and the state before the latch, see Update()
+	if(bPressed)
+	{
+		FPlatformAtomics::InterlockedIncrement(&ButtonEdgeCounts[Slot].Presses);
+		AtomicOr(&Word.Pressed, Mask);
+		AtomicOr(&Word.PressLatch, Mask);
+	}
+	else
+	{
+		FPlatformAtomics::InterlockedIncrement(&ButtonEdgeCounts[Slot].Releases);
+		AtomicAnd(&Word.Pressed, ~Mask);
+		AtomicOr(&Word.ReleaseLatch, Mask);
+	}
+}
+
+bool VRPNButtonInputDevice::IsSlotPressed(int32 Slot) const {
+	return (ButtonWords[Slot / ButtonsPerWord].Pressed & (int64(1) << (Slot % ButtonsPerWord))) != 0;
+}
+
+bool VRPNButtonInputDevice::IsButtonPressed(int32 ButtonId) const {
+	const int32 Slot = FindSlot(ButtonSlots, ButtonId);
+	return Slot != INDEX_NONE && IsSlotPressed(Slot);
+}
+
+int32 VRPNButtonInputDevice::FindButton(const FName &Name) const {
+	for(int32 Slot = 0; Slot < ButtonKeys.Num(); ++Slot)
+	{
+		if(ButtonKeys[Slot].GetFName() == Name)
+		{
+			return Slot;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool VRPNButtonInputDevice::GetButton(int32 Index) const {
+	return ButtonKeys.IsValidIndex(Index) && IsSlotPressed(Index);
+}
+
+void VRPNButtonInputDevice::MuteButton(int32 Index) {
+	if(ButtonKeys.IsValidIndex(Index))
+	{
+		ButtonWords[Index / ButtonsPerWord].Muted |= int64(1) << (Index % ButtonsPerWord);
+	}
+}
 
-	return ButtonMap.Num() > 0;
+void VRPNButtonInputDevice::PollSampleSource() {
+	FVRPNSharedMemorySample Samples[SampleBatchSize];
+	int32 NumSamples;
+	do
+	{
+		NumSamples = SampleSource->Poll(Samples, SampleBatchSize);
+		for(int32 i = 0; i < NumSamples; ++i)
+		{
+			const FVRPNSharedMemorySample &Sample = Samples[i];
+			if(Sample.Type != EVRPNSharedMemorySampleType::Button)
+			{
+				continue;
+			}
+			vrpn_BUTTONCB ButtonReport;
+			ButtonReport.msg_time = SampleTimeToTimeval(Sample.Time);
+			ButtonReport.button = Sample.Sensor;
+			ButtonReport.state = Sample.Data[0] != 0.0 ? 1 : 0;
+			HandleButtonDevice(this, ButtonReport);
+		}
+	} while(NumSamples == SampleBatchSize);
 }
 
 void VRPN_CALLBACK VRPNButtonInputDevice::HandleButtonDevice(void *userData, vrpn_BUTTONCB const b) {
 	VRPNButtonInputDevice &ButtonDevice = *reinterpret_cast<VRPNButtonInputDevice*>(userData);
-	ButtonDevice.KeyPressStack.Push({b.button,b.state});
+	const int32 Slot = FindSlot(ButtonDevice.ButtonSlots, b.button);
+	if(Slot == INDEX_NONE)
+	{
+		ButtonDevice.WarnUnknownSensor(TEXT("button"), b.button);
+		return;
+	}
+
+	ButtonDevice.SetButtonState(Slot, b.state != 0);
+
+	// Only the clock estimate and the statistics need the lock, the button state does not
+	FScopeLock StateLock(&ButtonDevice.StateCritSect);
+	ButtonDevice.AddReport();
+	ButtonDevice.ClockSync.AddSample(b.msg_time, FPlatformTime::Seconds());
+	ButtonDevice.SampleTime = ButtonDevice.ClockSync.ServerToLocalTime(b.msg_time);
 }
 
 //--------------------------------TRACKER-----------------------------
@@ -114,12 +650,17 @@ void VRPN_CALLBACK VRPNButtonInputDevice::HandleButtonDevice(void *userData, vrp
 VRPNTrackerInputDevice::VRPNTrackerInputDevice(const FString &TrackerAddress, FCriticalSection& InCritSect, bool bEnabled):
 IVRPNInputDevice(InCritSect),
 InputDevice(nullptr),
+FirstTrackerToUpdate(0),
 TranslationOffset(0,0,0),
 RotationOffset(EForceInit::ForceInit),
 TrackerUnitsToUE4Units(1.0f),
 FlipZAxis(false)
 {
-	if(bEnabled){
+	// Trackers are usually the head and hands, these should be updated every frame
+	Priority = EVRPNDevicePriority::High;
+	if(bEnabled && IsSampleSourceAddress(TrackerAddress)){
+		SampleSource = CreateSampleSource(TrackerAddress, EVRPNSharedMemorySampleType::Tracker);
+	} else if(bEnabled){
 		InputDevice = new vrpn_Tracker_Remote(TCHAR_TO_UTF8(*TrackerAddress));
 		//InputDevice->shutup = true;
 		InputDevice->register_change_handler(this, &VRPNTrackerInputDevice::HandleTrackerDevice);
@@ -131,42 +672,74 @@ VRPNTrackerInputDevice::~VRPNTrackerInputDevice() {
 }
 
 void VRPNTrackerInputDevice::Update() {
-	if(InputDevice){
+	if(InputDevice && !bPolledExternally){
+		FScopeLock ScopeLock(&CritSect);
+		InputDevice->mainloop();
+	} else if(SampleSource){
+		PollSampleSource();
+	}
+	const int32 NumTrackers = TrackerSamples.Num();
+	int32 NumEvents = 0;
+	const FModifierKeysState ModifierKeys = GetModifierKeys();
+	for(int32 i = 0; i < NumTrackers; ++i)
+	{
+		const int32 Slot = (FirstTrackerToUpdate + i) % NumTrackers;
+
+		// The keys are only touched here and when the events are send
+		const TrackerInfo &Info = TrackerInfos[Slot];
+		int32 NumTrackerEvents = 0;
+		for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
 		{
-			FScopeLock ScopeLock(&CritSect);
-			InputDevice->mainloop();
+			NumTrackerEvents += (Info.MutedAxes & (1 << Axis)) ? 0 : 1;
 		}
-		for(auto &InputPair : TrackerMap)
+		// The axes of a pose are send together, a tracker that does not fit waits for the next update.
+		// The first tracker of an update is always send, otherwise a MaxEventsPerTick below six would stop the device.
+		if(MaxEventsPerTick > 0 && NumEvents > 0 && NumEvents + NumTrackerEvents > MaxEventsPerTick)
 		{
-			TrackerInput &Input = InputPair.Value;
-			if(Input.TrackerDataDirty)
-			{
-				// Before firing events, transform the tracker into the right coordinate space
+			// Continue here in the next update so every tracker gets its turn
+			FirstTrackerToUpdate = Slot;
+			break;
+		}
 
-				FVector NewPosition;
-				FQuat NewRotation;
-				TransformCoordinates(Input, NewPosition, NewRotation);
+		FVector TrackerPosition;
+		FQuat TrackerRotation;
+		double SampleTime;
+		{
+			FScopeLock StateLock(&StateCritSect);
+			TrackerSample &Sample = TrackerSamples[Slot];
+			if(!Sample.TrackerDataDirty)
+			{
+				continue;
+			}
+			TrackerPosition = Sample.CurrentTrackerPosition;
+			TrackerRotation = Sample.CurrentTrackerRotation;
+			SampleTime = Sample.SampleTime;
+			Sample.TrackerDataDirty = false;
+		}
+		if(SampleTime > 0.0)
+		{
+			ReceiveAgeStats.AddSample(FMath::Max(FPlatformTime::Seconds() - SampleTime, 0.0));
+		}
 
-				FRotator NewRotator = NewRotation.Rotator();
+		// Before firing events, transform the tracker into the right coordinate space
 
-				FAnalogInputEvent AnalogInputEventX(Input.MotionXKey, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, NewPosition.X);
-				FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEventX);
-				FAnalogInputEvent AnalogInputEventY(Input.MotionYKey, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, NewPosition.Y);
-				FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEventY);
-				FAnalogInputEvent AnalogInputEventZ(Input.MotionZKey, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, NewPosition.Z);
-				FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEventZ);
+		FVector NewPosition;
+		FQuat NewRotation;
+		TransformCoordinates(TrackerPosition, TrackerRotation, NewPosition, NewRotation);
 
-				FAnalogInputEvent AnalogInputEventRotX(Input.RotationYawKey, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, NewRotator.Yaw);
-				FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEventRotX);
-				FAnalogInputEvent AnalogInputEventRotY(Input.RotationPitchKey, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, NewRotator.Pitch);
-				FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEventRotY);
-				FAnalogInputEvent AnalogInputEventRotZ(Input.RotationRollKey, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, NewRotator.Roll);
-				FSlateApplication::Get().ProcessAnalogInputEvent(AnalogInputEventRotZ);
+		FRotator NewRotator = NewRotation.Rotator();
 
-				Input.TrackerDataDirty = false;
+		for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
+		{
+			if(Info.MutedAxes & (1 << Axis))
+			{
+				continue;
 			}
+			SendAxisEvent(Info.Keys[Axis], GetPoseAxis(NewPosition, NewRotator, Axis), ModifierKeys);
+			++NumEvents;
 		}
 	}
+	Stats.NumEvents += NumEvents;
 }
 
 bool VRPNTrackerInputDevice::ParseConfig(FConfigSection *InConfigSection) {
@@ -229,16 +802,16 @@ bool VRPNTrackerInputDevice::ParseConfig(FConfigSection *InConfigSection) {
 		return false;
 	}
 
-	bool bHasMotionControllers = false;
-
+	KeyDetails.Reserve(Trackers.Num() * NumPoseAxes);
 	for(const FConfigValue* TrackerString: Trackers)
 	{
+		const TCHAR *TrackerConfig = *TrackerString->GetValue();
 		int32 TrackerId;
 		FString TrackerName;
 		FString TrackerDescription;
-		if(!FParse::Value(*TrackerString->GetValue(), TEXT("Id="), TrackerId) ||
-		   !FParse::Value(*TrackerString->GetValue(), TEXT("Name="), TrackerName) ||
-		   !FParse::Value(*TrackerString->GetValue(), TEXT("Description="), TrackerDescription))
+		if(!FParse::Value(TrackerConfig, TEXT("Id="), TrackerId) ||
+		   !FParse::Value(TrackerConfig, TEXT("Name="), TrackerName) ||
+		   !FParse::Value(TrackerConfig, TEXT("Description="), TrackerDescription))
 		{
 			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config not parse tracker. Expected: Tracker = (Id=#,Name=String,Description=String)."));
 			continue;
@@ -246,14 +819,13 @@ bool VRPNTrackerInputDevice::ParseConfig(FConfigSection *InConfigSection) {
 		
 		// see if this is a motion controller
 		int PlayerId = -1;
-		FParse::Value(*TrackerString->GetValue(), TEXT("PlayerId="), PlayerId);
+		FParse::Value(TrackerConfig, TEXT("PlayerId="), PlayerId);
 		EControllerHand Hand = EControllerHand::Left;
 		if(PlayerId >= 0)
 		{
 			UE_LOG(LogVRPNInputDevice, Log, TEXT("Found motion controller."));
-			bHasMotionControllers = true;
 			FString HandString;
-			if(FParse::Value(*TrackerString->GetValue(), TEXT("Hand="), HandString))
+			if(FParse::Value(TrackerConfig, TEXT("Hand="), HandString))
 			{
 				if(HandString.Equals("Right"))
 				{
@@ -265,34 +837,78 @@ bool VRPNTrackerInputDevice::ParseConfig(FConfigSection *InConfigSection) {
 		
 		UE_LOG(LogVRPNInputDevice, Log, TEXT("Adding new tracker: [%i,%s,%s,%i]."), TrackerId, *TrackerName, *TrackerDescription, PlayerId);
 		
-		const TrackerInput &Input = TrackerMap.Add(TrackerId, {FKey(*(TrackerName + "MotionX")), FKey(*(TrackerName + "MotionY")), FKey(*(TrackerName + "MotionZ")),
-													FKey(*(TrackerName + "RotationYaw")), FKey(*(TrackerName + "RotationPitch")), FKey(*(TrackerName + "RotationRoll")),
-													FVector(0), FQuat(EForceInit::ForceInit), PlayerId, Hand,false});
-
-		// Translation
-		EKeys::AddKey(FKeyDetails(Input.MotionXKey, FText::FromString(TrackerName + " X position"), FKeyDetails::FloatAxis));
-		EKeys::AddKey(FKeyDetails(Input.MotionYKey, FText::FromString(TrackerName + " Y position"), FKeyDetails::FloatAxis));
-		EKeys::AddKey(FKeyDetails(Input.MotionZKey, FText::FromString(TrackerName + " Z position"), FKeyDetails::FloatAxis));
+		const int32 Slot = AddTracker(TrackerId, TrackerName, PlayerId, Hand);
+		if(Slot == INDEX_NONE)
+		{
+			continue;
+		}
 
-		// Rotation
-		EKeys::AddKey(FKeyDetails(Input.RotationYawKey, FText::FromString(TrackerName + " Yaw"), FKeyDetails::FloatAxis));
-		EKeys::AddKey(FKeyDetails(Input.RotationPitchKey, FText::FromString(TrackerName + " Pitch"), FKeyDetails::FloatAxis));
-		EKeys::AddKey(FKeyDetails(Input.RotationRollKey, FText::FromString(TrackerName + " Roll"), FKeyDetails::FloatAxis));
+		// Translation and rotation
+		for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
+		{
+			KeyDetails.Add(FKeyDetails(TrackerInfos[Slot].Keys[Axis], FText::FromString(TrackerName + PoseAxisDescriptions[Axis]), FKeyDetails::FloatAxis));
+		}
 	}
 
-	if(bHasMotionControllers)
+	return true;
+}
+
+void VRPNTrackerInputDevice::SerializeDeviceConfig(FArchive &Ar)
+{
+	Ar << TranslationOffset << RotationOffset << TrackerUnitsToUE4Units << FlipZAxis;
+	int32 NumTrackers = TrackerInfos.Num();
+	Ar << NumTrackers;
+	for(int32 Slot = 0; Slot < NumTrackers && !Ar.IsError(); ++Slot)
 	{
-		UE_LOG(LogVRPNInputDevice, Log, TEXT("Adding this to the motion controller devices."));
-		IModularFeatures::Get().RegisterModularFeature(GetModularFeatureName(), this);
+		int32 TrackerId = 0;
+		FString TrackerName;
+		int32 PlayerIndex = -1;
+		uint8 Hand = 0;
+		if(Ar.IsSaving())
+		{
+			const TrackerInfo &Info = TrackerInfos[Slot];
+			TrackerId = Info.TrackerId;
+			TrackerName = Info.TrackerName.ToString();
+			PlayerIndex = Info.PlayerIndex;
+			Hand = static_cast<uint8>(Info.Hand);
+		}
+		Ar << TrackerId << TrackerName << PlayerIndex << Hand;
+		if(Ar.IsLoading())
+		{
+			AddTracker(TrackerId, TrackerName, PlayerIndex, static_cast<EControllerHand>(Hand));
+		}
 	}
+}
 
-
-	return true;
+int32 VRPNTrackerInputDevice::AddTracker(int32 TrackerId, const FString &TrackerName, int PlayerIndex, EControllerHand Hand)
+{
+	int32 Slot = FindSlot(TrackerSlots, TrackerId);
+	if(Slot == INDEX_NONE)
+	{
+		Slot = TrackerInfos.Num();
+		if(!SetSlot(TrackerSlots, TrackerId, Slot))
+		{
+			return INDEX_NONE;
+		}
+		TrackerInfos.AddDefaulted();
+		TrackerSamples.Add({FQuat(EForceInit::ForceInit), FVector(0), false, 0.0});
+	}
+	TrackerInfo &Info = TrackerInfos[Slot];
+	Info.TrackerName = FName(*TrackerName);
+	Info.TrackerId = TrackerId;
+	Info.PlayerIndex = PlayerIndex;
+	Info.Hand = Hand;
+	Info.MutedAxes = 0;
+	for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
+	{
+		Info.Keys[Axis] = FKey(*(TrackerName + PoseAxisKeySuffixes[Axis]));
+	}
+	return Slot;
 }
 
-void VRPNTrackerInputDevice::TransformCoordinates(const TrackerInput &Tracker, FVector &OutPosition, FQuat &OutRotation) const
+void VRPNTrackerInputDevice::TransformCoordinates(const FVector &TrackerPosition, const FQuat &TrackerRotation, FVector &OutPosition, FQuat &OutRotation) const
 {
-	FVector NewPosition = Tracker.CurrentTrackerPosition;
+	FVector NewPosition = TrackerPosition;
 	FVector NewTranslationOffset = TranslationOffset;
 	if(FlipZAxis)
 	{
@@ -317,7 +933,7 @@ void VRPNTrackerInputDevice::TransformCoordinates(const TrackerInput &Tracker, F
 		WorldToScale = OurWorld->GetWorldSettings()->WorldToMeters * 0.01f;
 	}
 	OutPosition = RotationOffset.RotateVector((NewPosition + NewTranslationOffset)*TrackerUnitsToUE4Units*WorldToScale);
-	FQuat NewRotation = Tracker.CurrentTrackerRotation;
+	FQuat NewRotation = TrackerRotation;
 	if(FlipZAxis)
 	{
 		NewRotation.X = -NewRotation.X;
@@ -326,69 +942,214 @@ void VRPNTrackerInputDevice::TransformCoordinates(const TrackerInput &Tracker, F
 	OutRotation = RotationOffset*NewRotation;
 }
 
-bool VRPNTrackerInputDevice::GetControllerOrientationAndPosition(const int32 ControllerIndex, const EControllerHand DeviceHand, FRotator& OutOrientation, FVector& OutPosition) const
+void VRPNTrackerInputDevice::RegisterMotionControllers(FVRPNMotionController &MotionController)
+{
+	for(const TrackerInfo &Info : TrackerInfos)
+	{
+		if(Info.PlayerIndex >= 0)
+		{
+			MotionController.AddController(Info.PlayerIndex, Info.Hand, this, Info.TrackerId);
+		}
+	}
+}
+
+bool VRPNTrackerInputDevice::GetTrackerPose(int32 TrackerId, FRotator &OutOrientation, FVector &OutPosition) const
 {
-	for(auto &InputPair : TrackerMap)
+	const int32 Slot = FindSlot(TrackerSlots, TrackerId);
+	if(Slot == INDEX_NONE)
 	{
-		const TrackerInput &Tracker = InputPair.Value;
-		if(Tracker.PlayerIndex == ControllerIndex && Tracker.Hand == DeviceHand)
+		return false;
+	}
+
+	FVector NewPosition;
+	FQuat NewRotation;
+	GetPose(Slot, NewPosition, NewRotation);
+
+	OutOrientation = NewRotation.Rotator();
+	OutPosition = NewPosition;
+	return true;
+}
+
+int32 VRPNTrackerInputDevice::FindAxis(const FName &Name) const
+{
+	for(int32 Slot = 0; Slot < TrackerInfos.Num(); ++Slot)
+	{
+		for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
 		{
-			if(InputDevice)
+			if(TrackerInfos[Slot].Keys[Axis].GetFName() == Name)
 			{
-				FScopeLock ScopeLock(&CritSect);
-				InputDevice->mainloop();
+				return Slot * NumPoseAxes + Axis;
 			}
+		}
+	}
+	return INDEX_NONE;
+}
 
-			FVector NewPosition;
-			FQuat NewRotation;
-			TransformCoordinates(Tracker, NewPosition, NewRotation);
+float VRPNTrackerInputDevice::GetAxis(int32 Index) const
+{
+	FVector Position;
+	FQuat Rotation;
+	if(!GetPose(Index / NumPoseAxes, Position, Rotation))
+	{
+		return 0.0f;
+	}
+	return GetPoseAxis(Position, Rotation.Rotator(), Index % NumPoseAxes);
+}
 
-			OutOrientation = NewRotation.Rotator();
-			OutPosition = NewPosition;
-			return true;
+int32 VRPNTrackerInputDevice::FindPose(const FName &Name) const
+{
+	for(int32 Slot = 0; Slot < TrackerInfos.Num(); ++Slot)
+	{
+		if(TrackerInfos[Slot].TrackerName == Name)
+		{
+			return Slot;
 		}
 	}
+	return INDEX_NONE;
+}
+
+void VRPNTrackerInputDevice::MuteAxis(int32 Index)
+{
+	if(Index >= 0 && TrackerInfos.IsValidIndex(Index / NumPoseAxes))
+	{
+		TrackerInfos[Index / NumPoseAxes].MutedAxes |= 1 << (Index % NumPoseAxes);
+	}
+}
+
+void VRPNTrackerInputDevice::MutePose(int32 Index)
+{
+	if(TrackerInfos.IsValidIndex(Index))
+	{
+		TrackerInfos[Index].MutedAxes = (1 << NumPoseAxes) - 1;
+	}
+}
 
-	return false;
+bool VRPNTrackerInputDevice::GetPose(int32 Index, FVector &OutPosition, FQuat &OutRotation) const
+{
+	if(!TrackerSamples.IsValidIndex(Index))
+	{
+		return false;
+	}
+	FVector TrackerPosition;
+	FQuat TrackerRotation;
+	{
+		FScopeLock StateLock(&StateCritSect);
+		TrackerPosition = TrackerSamples[Index].CurrentTrackerPosition;
+		TrackerRotation = TrackerSamples[Index].CurrentTrackerRotation;
+	}
+	TransformCoordinates(TrackerPosition, TrackerRotation, OutPosition, OutRotation);
+	return true;
 }
 
-// for now always return tracked, need to see later if we can return better information
-ETrackingStatus VRPNTrackerInputDevice::GetControllerTrackingStatus(const int32 ControllerIndex, const EControllerHand DeviceHand) const {
-	return ETrackingStatus::Tracked;
+void VRPNTrackerInputDevice::SerializeClusterState(FArchive &Ar) {
+	FScopeLock StateLock(&StateCritSect);
+	int32 NumTrackers = TrackerSamples.Num();
+	Ar << NumTrackers;
+	if(Ar.IsLoading())
+	{
+		for(int32 i = 0; i < NumTrackers && !Ar.IsError(); ++i)
+		{
+			int32 TrackerId;
+			FVector Position;
+			FQuat Rotation;
+			Ar << TrackerId << Position << Rotation;
+			const int32 Slot = FindSlot(TrackerSlots, TrackerId);
+			if(Slot == INDEX_NONE)
+			{
+				continue;
+			}
+			TrackerSample &Sample = TrackerSamples[Slot];
+			if(Sample.CurrentTrackerPosition != Position || !Sample.CurrentTrackerRotation.Equals(Rotation, 0.0f))
+			{
+				Sample.CurrentTrackerPosition = Position;
+				Sample.CurrentTrackerRotation = Rotation;
+				Sample.SampleTime = 0.0;
+				Sample.TrackerDataDirty = true;
+			}
+		}
+	}
+	else
+	{
+		for(int32 Slot = 0; Slot < TrackerSamples.Num(); ++Slot)
+		{
+			int32 TrackerId = TrackerInfos[Slot].TrackerId;
+			Ar << TrackerId << TrackerSamples[Slot].CurrentTrackerPosition << TrackerSamples[Slot].CurrentTrackerRotation;
+		}
+	}
+}
+
+void VRPNTrackerInputDevice::PollSampleSource() {
+	FVRPNSharedMemorySample Samples[SampleBatchSize];
+	int32 NumSamples;
+	do
+	{
+		NumSamples = SampleSource->Poll(Samples, SampleBatchSize);
+		for(int32 i = 0; i < NumSamples; ++i)
+		{
+			const FVRPNSharedMemorySample &Sample = Samples[i];
+			if(Sample.Type != EVRPNSharedMemorySampleType::Tracker)
+			{
+				continue;
+			}
+			vrpn_TRACKERCB TrackerReport;
+			TrackerReport.msg_time = SampleTimeToTimeval(Sample.Time);
+			TrackerReport.sensor = Sample.Sensor;
+			for(int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				TrackerReport.pos[Axis] = Sample.Data[Axis];
+			}
+			for(int32 Component = 0; Component < 4; ++Component)
+			{
+				TrackerReport.quat[Component] = Sample.Data[3 + Component];
+			}
+			HandleTrackerDevice(this, TrackerReport);
+		}
+	} while(NumSamples == SampleBatchSize);
 }
 
 void VRPN_CALLBACK VRPNTrackerInputDevice::HandleTrackerDevice(void *userData, vrpn_TRACKERCB const tr) {
 	VRPNTrackerInputDevice &TrackerDevice = *reinterpret_cast<VRPNTrackerInputDevice*>(userData);
-	TrackerInput *Input = TrackerDevice.TrackerMap.Find(tr.sensor);
-	if(Input == nullptr)
+	const int32 Slot = FindSlot(TrackerDevice.TrackerSlots, tr.sensor);
+	if(Slot == INDEX_NONE)
 	{
-		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not find tracker with id %i."), tr.sensor);
+		TrackerDevice.WarnUnknownSensor(TEXT("tracker"), tr.sensor);
 		return;
 	}
 
-	Input->TrackerDataDirty = true;
+	FScopeLock StateLock(&TrackerDevice.StateCritSect);
+	TrackerDevice.AddReport();
+	TrackerSample &Sample = TrackerDevice.TrackerSamples[Slot];
+	Sample.TrackerDataDirty = true;
+	TrackerDevice.ClockSync.AddSample(tr.msg_time, FPlatformTime::Seconds());
+	Sample.SampleTime = TrackerDevice.ClockSync.ServerToLocalTime(tr.msg_time);
 
-	Input->CurrentTrackerPosition.X = tr.pos[0];
-	Input->CurrentTrackerPosition.Y = tr.pos[1];
-	Input->CurrentTrackerPosition.Z = tr.pos[2];
+	Sample.CurrentTrackerPosition.X = tr.pos[0];
+	Sample.CurrentTrackerPosition.Y = tr.pos[1];
+	Sample.CurrentTrackerPosition.Z = tr.pos[2];
 
 	FQuat NewRotation = FQuat(tr.quat[0], tr.quat[1], tr.quat[2], tr.quat[3]);
 
-	Input->CurrentTrackerRotation = FQuat::Slerp(Input->CurrentTrackerRotation, NewRotation, 0.2f);
+	Sample.CurrentTrackerRotation = FQuat::Slerp(Sample.CurrentTrackerRotation, NewRotation, 0.2f);
 
-	Input->CurrentTrackerRotation.X = tr.quat[0];
-	Input->CurrentTrackerRotation.Y = tr.quat[1];
-	Input->CurrentTrackerRotation.Z = tr.quat[2];
-	Input->CurrentTrackerRotation.W = tr.quat[3];
+	Sample.CurrentTrackerRotation.X = tr.quat[0];
+	Sample.CurrentTrackerRotation.Y = tr.quat[1];
+	Sample.CurrentTrackerRotation.Z = tr.quat[2];
+	Sample.CurrentTrackerRotation.W = tr.quat[3];
 }
 
 //--------------------------------ANALOG-----------------------------
 
 VRPNAnalogInputDevice::VRPNAnalogInputDevice(const FString & TrackerAddress, FCriticalSection & InCritSect, bool bEnabled):
 IVRPNInputDevice(InCritSect),
-InputDevice(nullptr)
+InputDevice(nullptr),
+num_channel(0),
+SampleTime(0.0),
+FirstChannelToUpdate(0)
 {
-	if (bEnabled) {
+	FMemory::Memzero(MutedChannels, sizeof(MutedChannels));
+	if (bEnabled && IsSampleSourceAddress(TrackerAddress)) {
+		SampleSource = CreateSampleSource(TrackerAddress, EVRPNSharedMemorySampleType::Analog);
+	} else if (bEnabled) {
 		InputDevice = new vrpn_Analog_Remote(TCHAR_TO_UTF8(*TrackerAddress));
 		//InputDevice->shutup = true;
 		InputDevice->register_change_handler(this, &VRPNAnalogInputDevice::HandleAnalogDevice);
@@ -401,23 +1162,52 @@ VRPNAnalogInputDevice::~VRPNAnalogInputDevice(){
 
 void VRPNAnalogInputDevice::Update()
 {
-	if (InputDevice) {
+	if (InputDevice && !bPolledExternally) {
+		FScopeLock ScopeLock(&CritSect);
+		InputDevice->mainloop();
+	} else if (SampleSource) {
+		PollSampleSource();
+	}
+	// Copy the values so the callbacks are not blocked while Slate handles the events
+	vrpn_float64 Values[vrpn_CHANNEL_MAX];
+	int32 NumChannels;
+	double ReportTime;
+	{
+		FScopeLock StateLock(&StateCritSect);
+		NumChannels = num_channel;
+		FMemory::Memcpy(Values, channels, NumChannels * sizeof(vrpn_float64));
+		ReportTime = SampleTime;
+		SampleTime = 0.0;
+	}
+	if (ReportTime > 0.0)
+	{
+		ReceiveAgeStats.AddSample(FMath::Max(FPlatformTime::Seconds() - ReportTime, 0.0));
+	}
+	const FModifierKeysState ModifierKeys = GetModifierKeys();
+	int32 NumEvents = 0;
+	int32 NumVisited = 0;
+	for (; NumVisited < NumChannels; ++NumVisited)
+	{
+		if (MaxEventsPerTick > 0 && NumEvents >= MaxEventsPerTick)
 		{
-			FScopeLock ScopeLock(&CritSect);
-			InputDevice->mainloop();
+			break;
 		}
-		for (int a = 0; a < num_channel; a = a + 1)
+		const int a = (FirstChannelToUpdate + NumVisited) % NumChannels;
+		if (a >= ChannelKeys.Num() || ChannelKeys[a].GetFName().IsNone())
 		{
-			const FKey* Key = ChannelMap.Find(a);
-			if (Key == nullptr)
-			{
-				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not find button with id %i."), a);
-				return;
-			}
-			FAnalogInputEvent AnalogChannel(*Key, FSlateApplication::Get().GetModifierKeys(), 0, 0, 0, 0, channels[a]);
-			FSlateApplication::Get().ProcessAnalogInputEvent(AnalogChannel);
+			WarnUnknownSensor(TEXT("channel"), a);
+			continue;
 		}
+		if (MutedChannels[a])
+		{
+			continue;
+		}
+		SendAxisEvent(ChannelKeys[a], Values[a], ModifierKeys);
+		++NumEvents;
 	}
+	Stats.NumEvents += NumEvents;
+	// When not all channels were send continue with the next channel in the next update
+	FirstChannelToUpdate = NumChannels > 0 ? (FirstChannelToUpdate + NumVisited) % NumChannels : 0;
 }
 
 bool VRPNAnalogInputDevice::ParseConfig(FConfigSection * InConfigSection)
@@ -430,32 +1220,301 @@ bool VRPNAnalogInputDevice::ParseConfig(FConfigSection * InConfigSection)
 		return false;
 	}
 
+	KeyDetails.Reserve(Channels.Num());
 	for (const FConfigValue* ChannelString : Channels)
 	{
+		const TCHAR *ChannelConfig = *ChannelString->GetValue();
 		int32 ChannelId;
 		FString ChannelName;
 		FString ChannelDescription;
-		if (!FParse::Value(*ChannelString->GetValue(), TEXT("Id="), ChannelId) ||
-			!FParse::Value(*ChannelString->GetValue(), TEXT("Name="), ChannelName) ||
-			!FParse::Value(*ChannelString->GetValue(), TEXT("Description="), ChannelDescription))
+		if (!FParse::Value(ChannelConfig, TEXT("Id="), ChannelId) ||
+			!FParse::Value(ChannelConfig, TEXT("Name="), ChannelName) ||
+			!FParse::Value(ChannelConfig, TEXT("Description="), ChannelDescription))
 		{
 			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config not parse channel. Expected: Channel = (Id=#,Name=String,Description=String)."));
 			continue;
 		}
-		// While NewKey is only valid for this iteration it will be copied in FKeyDetails below
-		const FKey &NewKey = ChannelMap.Add(ChannelId, FKey(*ChannelName));
-		EKeys::AddKey(FKeyDetails(NewKey, FText::FromString(ChannelDescription), FKeyDetails::FloatAxis));
+		if (ChannelId < 0 || ChannelId >= vrpn_CHANNEL_MAX)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Channel id %i is out of range, ids should be between 0 and %i."), ChannelId, vrpn_CHANNEL_MAX - 1);
+			continue;
+		}
+		if (ChannelId >= ChannelKeys.Num())
+		{
+			ChannelKeys.SetNum(ChannelId + 1);
+		}
+		ChannelKeys[ChannelId] = FKey(*ChannelName);
+		KeyDetails.Add(FKeyDetails(ChannelKeys[ChannelId], FText::FromString(ChannelDescription), FKeyDetails::FloatAxis));
+	}
+
+	return ChannelKeys.Num() > 0;
+}
+
+void VRPNAnalogInputDevice::SerializeDeviceConfig(FArchive & Ar)
+{
+	int32 NumChannelKeys = ChannelKeys.Num();
+	Ar << NumChannelKeys;
+	if (Ar.IsLoading())
+	{
+		ChannelKeys.SetNum(FMath::Clamp(NumChannelKeys, 0, static_cast<int32>(vrpn_CHANNEL_MAX)));
+	}
+	for (int32 ChannelId = 0; ChannelId < ChannelKeys.Num() && !Ar.IsError(); ++ChannelId)
+	{
+		FName KeyName = ChannelKeys[ChannelId].GetFName();
+		Ar << KeyName;
+		if (Ar.IsLoading())
+		{
+			ChannelKeys[ChannelId] = FKey(KeyName);
+		}
 	}
+}
+
+void VRPNAnalogInputDevice::SerializeClusterState(FArchive & Ar)
+{
+	FScopeLock StateLock(&StateCritSect);
+	int32 NumChannels = num_channel;
+	Ar << NumChannels;
+	if (Ar.IsLoading())
+	{
+		num_channel = FMath::Clamp(NumChannels, 0, vrpn_CHANNEL_MAX);
+	}
+	for (int a = 0; a < num_channel; a = a + 1)
+	{
+		Ar << channels[a];
+	}
+}
+
+int32 VRPNAnalogInputDevice::FindAxis(const FName &Name) const
+{
+	for (int32 ChannelId = 0; ChannelId < ChannelKeys.Num(); ++ChannelId)
+	{
+		if (ChannelKeys[ChannelId].GetFName() == Name)
+		{
+			return ChannelId;
+		}
+	}
+	return INDEX_NONE;
+}
+
+float VRPNAnalogInputDevice::GetAxis(int32 Index) const
+{
+	FScopeLock StateLock(&StateCritSect);
+	return Index >= 0 && Index < num_channel ? channels[Index] : 0.0f;
+}
+
+void VRPNAnalogInputDevice::MuteAxis(int32 Index)
+{
+	if (Index >= 0 && Index < vrpn_CHANNEL_MAX)
+	{
+		MutedChannels[Index] = true;
+	}
+}
+
+void VRPNAnalogInputDevice::PollSampleSource()
+{
+	// The sample source has a sample per channel, collect them in a single analog report
+	vrpn_ANALOGCB AnalogReport;
+	AnalogReport.num_channel = num_channel;
+	FMemory::Memcpy(AnalogReport.channel, channels, sizeof(channels));
+	bool bHasReport = false;
 
-	return ChannelMap.Num() > 0;
+	FVRPNSharedMemorySample Samples[SampleBatchSize];
+	int32 NumSamples;
+	do
+	{
+		NumSamples = SampleSource->Poll(Samples, SampleBatchSize);
+		for (int32 i = 0; i < NumSamples; ++i)
+		{
+			const FVRPNSharedMemorySample &Sample = Samples[i];
+			if (Sample.Type != EVRPNSharedMemorySampleType::Analog || Sample.Sensor < 0 || Sample.Sensor >= vrpn_CHANNEL_MAX)
+			{
+				continue;
+			}
+			AnalogReport.msg_time = SampleTimeToTimeval(Sample.Time);
+			AnalogReport.num_channel = FMath::Max(AnalogReport.num_channel, Sample.Sensor + 1);
+			AnalogReport.channel[Sample.Sensor] = Sample.Data[0];
+			bHasReport = true;
+		}
+	} while (NumSamples == SampleBatchSize);
+
+	if (bHasReport)
+	{
+		HandleAnalogDevice(this, AnalogReport);
+	}
 }
 
 void VRPN_CALLBACK VRPNAnalogInputDevice::HandleAnalogDevice(void * userData, vrpn_ANALOGCB const an)
 {
 	VRPNAnalogInputDevice &AnalogDevice = *reinterpret_cast<VRPNAnalogInputDevice*>(userData);
+	FScopeLock StateLock(&AnalogDevice.StateCritSect);
+	AnalogDevice.AddReport();
+	AnalogDevice.ClockSync.AddSample(an.msg_time, FPlatformTime::Seconds());
+	AnalogDevice.SampleTime = AnalogDevice.ClockSync.ServerToLocalTime(an.msg_time);
 	AnalogDevice.num_channel = an.num_channel;
 	for (int a = 0; a < AnalogDevice.num_channel; a = a + 1)
 	{
 		AnalogDevice.channels[a] = an.channel[a];
 	}
 }
+
+//--------------------------------ANALOG OUTPUT-----------------------------
+
+VRPNAnalogOutputDevice::VRPNAnalogOutputDevice(const FString & OutputAddress, FCriticalSection & InCritSect, bool bEnabled):
+IVRPNInputDevice(InCritSect),
+OutputDevice(nullptr),
+NumChannels(0),
+ChangeThreshold(0.01f),
+MinSendInterval(0.0),
+LastSendTime(0.0)
+{
+	FMemory::Memzero(PendingValues, sizeof(PendingValues));
+	FMemory::Memzero(SentValues, sizeof(SentValues));
+	if (bEnabled && IsSampleSourceAddress(OutputAddress)) {
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Analog output devices can not use shared memory or simulated samples, %s is ignored."), *OutputAddress);
+	} else if (bEnabled) {
+		// Use a connection of our own, VRPN would otherwise share it with input devices on the same server
+		// and those can be pumped by a polling thread while we send.
+		vrpn_Connection *Connection = vrpn_get_connection_by_name(TCHAR_TO_UTF8(*OutputAddress), nullptr, nullptr, nullptr, nullptr, nullptr, /*force_connection=*/true);
+		OutputDevice = new vrpn_Analog_Output_Remote(TCHAR_TO_UTF8(*OutputAddress), Connection);
+		if (Connection) {
+			// The remote holds its own reference
+			Connection->removeReference();
+		}
+	}
+}
+
+VRPNAnalogOutputDevice::~VRPNAnalogOutputDevice() {
+	delete OutputDevice;
+}
+
+void VRPNAnalogOutputDevice::Update()
+{
+	if (OutputDevice == nullptr) {
+		return;
+	}
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (CurrentTime - LastSendTime >= MinSendInterval) {
+		bool bChanged = false;
+		for (int a = 0; a < NumChannels; a = a + 1)
+		{
+			// Always send when a channel goes back to zero, otherwise the actuator could keep running
+			const bool bStopped = PendingValues[a] == 0.0 && SentValues[a] != 0.0;
+			if (bStopped || FMath::Abs(PendingValues[a] - SentValues[a]) > ChangeThreshold)
+			{
+				bChanged = true;
+				break;
+			}
+		}
+
+		if (bChanged && OutputDevice->request_change_channels(NumChannels, PendingValues)) {
+			FMemory::Memcpy(SentValues, PendingValues, NumChannels * sizeof(vrpn_float64));
+			LastSendTime = CurrentTime;
+		}
+	}
+
+	// This connection is only used here, so there is no need to wait for the VRPN lock
+	OutputDevice->mainloop();
+}
+
+bool VRPNAnalogOutputDevice::ParseConfig(FConfigSection * InConfigSection)
+{
+	FConfigValue *ThresholdConfigValue = InConfigSection->Find(FName(TEXT("Threshold")));
+	if (ThresholdConfigValue)
+	{
+		ChangeThreshold = FCString::Atof(*ThresholdConfigValue->GetValue());
+	}
+
+	FConfigValue *SendRateConfigValue = InConfigSection->Find(FName(TEXT("MaxSendRateHz")));
+	if (SendRateConfigValue)
+	{
+		const float SendRate = FCString::Atof(*SendRateConfigValue->GetValue());
+		MinSendInterval = SendRate > 0.0f ? 1.0 / SendRate : 0.0;
+	}
+
+	TArray<const FConfigValue*> Channels;
+	InConfigSection->MultiFindPointer(FName(TEXT("Channel")), Channels);
+	if (Channels.Num() == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config file for analog output device has no channel mappings specified. Expeted field Channel."));
+		return false;
+	}
+
+	for (const FConfigValue* ChannelString : Channels)
+	{
+		int32 ChannelId;
+		FString ForceFeedbackString;
+		if (!FParse::Value(*ChannelString->GetValue(), TEXT("Id="), ChannelId) ||
+			!FParse::Value(*ChannelString->GetValue(), TEXT("ForceFeedback="), ForceFeedbackString) ||
+			ChannelId < 0 || ChannelId >= vrpn_CHANNEL_MAX)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config not parse output channel. Expected: Channel = (Id=#,ForceFeedback=LeftLarge|LeftSmall|RightLarge|RightSmall,ControllerId=#)."));
+			continue;
+		}
+
+		OutputChannel Output;
+		Output.ChannelId = ChannelId;
+		Output.ControllerId = 0;
+		FParse::Value(*ChannelString->GetValue(), TEXT("ControllerId="), Output.ControllerId);
+		if (ForceFeedbackString.Equals("LeftLarge"))
+		{
+			Output.ChannelType = FForceFeedbackChannelType::LEFT_LARGE;
+		}
+		else if (ForceFeedbackString.Equals("LeftSmall"))
+		{
+			Output.ChannelType = FForceFeedbackChannelType::LEFT_SMALL;
+		}
+		else if (ForceFeedbackString.Equals("RightLarge"))
+		{
+			Output.ChannelType = FForceFeedbackChannelType::RIGHT_LARGE;
+		}
+		else if (ForceFeedbackString.Equals("RightSmall"))
+		{
+			Output.ChannelType = FForceFeedbackChannelType::RIGHT_SMALL;
+		}
+		else
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("ForceFeedback should be LeftLarge, LeftSmall, RightLarge or RightSmall but found %s."), *ForceFeedbackString);
+			continue;
+		}
+
+		OutputChannels.Add(Output);
+		NumChannels = FMath::Max(NumChannels, ChannelId + 1);
+	}
+
+	return OutputChannels.Num() > 0;
+}
+
+void VRPNAnalogOutputDevice::SerializeDeviceConfig(FArchive & Ar)
+{
+	Ar << ChangeThreshold << MinSendInterval << NumChannels;
+	NumChannels = FMath::Clamp<vrpn_int32>(NumChannels, 0, vrpn_CHANNEL_MAX);
+	int32 NumOutputs = OutputChannels.Num();
+	Ar << NumOutputs;
+	if (Ar.IsLoading())
+	{
+		OutputChannels.SetNum(FMath::Max(NumOutputs, 0));
+	}
+	for (OutputChannel &Output : OutputChannels)
+	{
+		int32 ChannelType = static_cast<int32>(Output.ChannelType);
+		Ar << Output.ChannelId << Output.ControllerId << ChannelType;
+		Output.ChannelType = static_cast<FForceFeedbackChannelType>(ChannelType);
+		if (Output.ChannelId < 0 || Output.ChannelId >= NumChannels)
+		{
+			Ar.SetError();
+			return;
+		}
+	}
+}
+
+void VRPNAnalogOutputDevice::SetForceFeedbackValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value)
+{
+	for (const OutputChannel &Output : OutputChannels)
+	{
+		if (Output.ControllerId == ControllerId && Output.ChannelType == ChannelType)
+		{
+			PendingValues[Output.ChannelId] = Value;
+		}
+	}
+}
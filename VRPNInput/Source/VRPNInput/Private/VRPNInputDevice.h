@@ -25,33 +25,232 @@ SOFTWARE.
 #pragma once
 
 #include "IMotionController.h"
+#include "VRPNSharedMemory.h"
+#include "VRPNClockSync.h"
+
+class FVRPNMotionController;
 
 #if PLATFORM_WINDOWS
 	#include "AllowWindowsPlatformTypes.h"
 		#include "vrpn_Tracker.h"
 		#include "vrpn_Button.h"
 		#include "vrpn_Analog.h"
+		#include "vrpn_Analog_Output.h"
 	#include "HideWindowsPlatformTypes.h"    
 #elif PLATFORM_LINUX
 	#include "vrpn_Tracker.h"
 	#include "vrpn_Button.h"
 	#include "vrpn_Analog.h"
+	#include "vrpn_Analog_Output.h"
 #endif
 
+/*
+ * Receives the key and axis events of all devices, by default these go to FSlateApplication.
+ * Tests install their own sink so they can drive the devices without sending input to the engine.
+ */
+class IVRPNEventSink
+{
+public:
+	virtual ~IVRPNEventSink() {}
+	virtual void SendKey(const FKey &Key, bool bPressed, const FModifierKeysState &ModifierKeys) = 0;
+	virtual void SendAxis(const FKey &Key, float Value, const FModifierKeysState &ModifierKeys) = 0;
+};
+
+/*
+ * The device manager updates the devices with a higher priority first.
+ * High priority devices (by default the trackers) are always updated, the others can be postponed to the next frame
+ * when the frame budget (-VRPNFrameBudgetMs=) is used up.
+ */
+enum class EVRPNDevicePriority
+{
+	Low,
+	Normal,
+	High
+};
+
 class IVRPNInputDevice
 {
 public:
-	IVRPNInputDevice(FCriticalSection& InCritSect) :CritSect(InCritSect){}
-	virtual ~IVRPNInputDevice(){};
+	IVRPNInputDevice(FCriticalSection& InCritSect) :CritSect(InCritSect), bPolledExternally(false), SampleSource(nullptr),
+		Priority(EVRPNDevicePriority::Normal), UpdateInterval(0.0), MaxEventsPerTick(0), bWarnedUnknownSensor(false), NumReportedLosses(0){}
+	virtual ~IVRPNInputDevice(){ delete SampleSource; };
 	virtual void Update() = 0;
 	virtual bool ParseConfig(FConfigSection *InConfigSection) = 0;
+
+	/*
+	 * Reads the settings that tell the device manager how often to update the device, these are the same for every type of device:
+	 * UpdateRateHz = maximum number of updates per second (default is every frame)
+	 * Priority = High, Normal or Low
+	 * MaxEventsPerTick = maximum number of key events that is send per update, the rest is send in the next update (default is no maximum).
+	 *                    A tracker sends up to six events (one per axis), a button two for a short tap and an analog channel one.
+	 */
+	void ParseSchedulingConfig(FConfigSection *InConfigSection);
+
+	/*
+	 * Saves or loads everything that ParseConfig and ParseSchedulingConfig read from the config file, used by the config cache.
+	 * A loaded device is the same as a device that parsed the config, including its key details.
+	 */
+	void SerializeConfig(FArchive &Ar);
+
+	/*
+	 * Registers the keys of this device with EKeys, the device manager does this for all devices in a single pass after they are created.
+	 * Returns the number of keys.
+	 */
+	int32 RegisterKeys();
+
+	EVRPNDevicePriority GetPriority() const { return Priority; }
+	// Minimum time in seconds between two updates, zero means every frame
+	double GetUpdateInterval() const { return UpdateInterval; }
+
+	/*
+	 * Writes (or when loading, applies) the current state of the device for cluster replication.
+	 * The primary node writes the raw VRPN state, replica nodes apply it in place of a VRPN connection.
+	 */
+	virtual void SerializeClusterState(FArchive &Ar) = 0;
+
+	/*
+	 * Returns the VRPN remote of this device, or nullptr if the device does not use a VRPN connection.
+	 */
+	virtual vrpn_BaseClass* GetRemote() const = 0;
+
+	/*
+	 * When enabled the device does not call mainloop() itself, a polling thread does this when data arrives.
+	 * The callbacks will then be called from that thread.
+	 */
+	void SetPolledExternally(bool bInPolledExternally) { bPolledExternally = bInPolledExternally; }
+
+	// The name of the config section, used when printing statistics
+	void SetDeviceName(const FString &InDeviceName) { DeviceName = InDeviceName; }
+	const FString& GetDeviceName() const { return DeviceName; }
+
+	/*
+	 * Prints the clock offset to the VRPN server and the receive age of the samples: how long after their server time stamp they were send to the engine.
+	 * The receive age statistics are reset afterwards.
+	 */
+	void DumpReceiveAgeStats(FOutputDevice &Ar);
+
+	// Throughput and cost of the device since the last DumpStats()
+	struct DeviceStats
+	{
+		DeviceStats() : NumReports(0), NumQueuedReports(0), MaxQueueDepth(0), NumEvents(0), NumUpdates(0), TotalUpdateTime(0.0), MaxUpdateTime(0.0) {}
+
+		// Written by the callbacks, guarded by StateCritSect
+		int64 NumReports;
+		// Reports since the last update, the highest number is the queue depth
+		int32 NumQueuedReports;
+		int32 MaxQueueDepth;
+
+		// Only used on the game thread
+		int64 NumEvents;
+		int64 NumUpdates;
+		double TotalUpdateTime;
+		double MaxUpdateTime;
+	};
+	DeviceStats GetStats() const;
+
+	/*
+	 * Prints the reports and events per second, the lost samples and dropped events, the highest queue depth and the cost of an update.
+	 * The rates are over ElapsedSeconds, the time since the previous call, the statistics are reset afterwards.
+	 * Returns the number of samples and events that were lost since the previous call.
+	 */
+	int64 DumpStats(FOutputDevice &Ar, double ElapsedSeconds);
+
+	// Called by the device manager with the time an Update() took
+	void AddUpdateTime(double Seconds);
+
+	// Events that never reached the engine, in total (e.g. a button that went down and up again within one update gives no events)
+	virtual int64 GetNumDroppedEvents() const { return 0; }
+
+	/*
+	 * Values that virtual devices use as their inputs, looked up by key name (for a tracker pose by the tracker name).
+	 * The Find functions return INDEX_NONE when this device has no such value, the index is then passed to the Get functions.
+	 * The Get functions return the latest received value and are called from the game thread.
+	 */
+	virtual int32 FindAxis(const FName &Name) const { return INDEX_NONE; }
+	virtual float GetAxis(int32 Index) const { return 0.0f; }
+	virtual int32 FindButton(const FName &Name) const { return INDEX_NONE; }
+	virtual bool GetButton(int32 Index) const { return false; }
+	virtual int32 FindPose(const FName &Name) const { return INDEX_NONE; }
+	virtual bool GetPose(int32 Index, FVector &OutPosition, FQuat &OutRotation) const { return false; }
+
+	/*
+	 * Stops the events of a value that a virtual device consumes (MuteInputs=True), the Get functions still return the value.
+	 * The index is the one returned by the Find function of the same kind, muting a pose mutes all its axes. Call these before the first update.
+	 */
+	virtual void MuteAxis(int32 Index) {}
+	virtual void MuteButton(int32 Index) {}
+	virtual void MutePose(int32 Index) {}
+
+	// The six axes of a pose in the order the tracker keys are send: X, Y, Z, yaw, pitch and roll
+	static const int32 NumPoseAxes = 6;
+	static float GetPoseAxis(const FVector &Position, const FRotator &Rotation, int32 Axis);
+	// The key of a pose axis is the tracker name followed by the suffix
+	static const TCHAR* const PoseAxisKeySuffixes[NumPoseAxes];
+	static const TCHAR* const PoseAxisDescriptions[NumPoseAxes];
+
+	// Sends the events of all devices to InEventSink instead of Slate, nullptr sends them to Slate again. Only call this between updates.
+	static void SetEventSink(IVRPNEventSink *InEventSink) { EventSink = InEventSink; }
 protected:
+	// Send an event to the event sink or to Slate, only called on the game thread
+	static FModifierKeysState GetModifierKeys();
+	static void SendKeyEvent(const FKey &Key, bool bPressed, const FModifierKeysState &ModifierKeys);
+	static void SendAxisEvent(const FKey &Key, float Value, const FModifierKeysState &ModifierKeys);
+	static IVRPNEventSink *EventSink;
+
 	FCriticalSection& CritSect;
+	bool bPolledExternally;
+
+	// Guards the state that is written by the VRPN callbacks, these can run on a polling thread
+	mutable FCriticalSection StateCritSect;
+
+	// Used instead of a VRPN connection when the address starts with shm:// or sim://
+	IVRPNSampleSource *SampleSource;
+	// Samples are copied from the sample source in batches of this size
+	static const int32 SampleBatchSize = 64;
+	// Returns nullptr when the address is a VRPN address
+	static IVRPNSampleSource* CreateSampleSource(const FString &Address, EVRPNSharedMemorySampleType Type);
+	static bool IsSampleSourceAddress(const FString &Address);
+
+	EVRPNDevicePriority Priority;
+	double UpdateInterval;
+	// Zero means no maximum
+	int32 MaxEventsPerTick;
+
+	FString DeviceName;
+
+	// Sensor ids are small, so the slot of an id is looked up in a table indexed by the id instead of a map
+	static const int32 MaxSensorId = 4095;
+	static int32 FindSlot(const TArray<int32> &Slots, int32 Id) { return Slots.IsValidIndex(Id) ? Slots[Id] : INDEX_NONE; }
+	// Returns false when the id is out of range
+	static bool SetSlot(TArray<int32> &Slots, int32 Id, int32 Slot);
+
+	// Writes or reads the device specific part of SerializeConfig
+	virtual void SerializeDeviceConfig(FArchive &Ar) = 0;
+
+	// The keys found in the config, they are kept until RegisterKeys() is called
+	TArray<FKeyDetails> KeyDetails;
+
+	// Only the first unknown sensor id is logged, a misconfigured device would otherwise log (and allocate) for every report
+	void WarnUnknownSensor(const TCHAR *SensorType, int32 Id);
+	bool bWarnedUnknownSensor;
+
+	// Converts the msg_time of the reports to local time, guarded by StateCritSect
+	FVRPNClockSync ClockSync;
+	// Receive age of the samples when they are send to the engine, only used on the game thread
+	FVRPNReceiveAgeStats ReceiveAgeStats;
+
+	DeviceStats Stats;
+	// Lost samples and dropped events at the previous DumpStats()
+	int64 NumReportedLosses;
+
+	// Counts a report for the statistics, called by the callbacks with StateCritSect locked
+	void AddReport() { ++Stats.NumReports; ++Stats.NumQueuedReports; }
 };
 
 /*
  * Connects to a VRPN button device.
- * gives an event for each putton up/down press
+ * The state of the buttons is kept in bitsets that the callbacks update with atomic operations,
+ * every update compares them with the state that was last send and gives an up or down event for each button that changed.
  */
 class VRPNButtonInputDevice : public IVRPNInputDevice
 {
@@ -63,30 +262,84 @@ public:
 
 	void Update() override;
 	bool ParseConfig(FConfigSection *InConfigSection) override;
+	void SerializeClusterState(FArchive &Ar) override;
+	vrpn_BaseClass* GetRemote() const override { return InputDevice; }
+
+	/*
+	 * Returns the latest received state of a button, this does not lock and can be called from any thread.
+	 */
+	bool IsButtonPressed(int32 ButtonId) const;
+
+	// The index of a button is its slot
+	int32 FindButton(const FName &Name) const override;
+	bool GetButton(int32 Index) const override;
+	void MuteButton(int32 Index) override;
+
+	int64 GetNumDroppedEvents() const override { return NumDroppedEvents; }
 
 private:
-	// because key presses callbacks be called in the render thread
-	// (due to motion controllers that call mainloop() in reanderthread)
-	// we keep a stack to process in the game thread
-	struct KeyEventPair{
-		vrpn_int32 Button;
-		vrpn_int32 State;
+	// The state of 64 buttons, bit N of word W is the button in slot W * 64 + N
+	struct ButtonWord
+	{
+		// Latest received state, written by the callbacks
+		volatile int64 Pressed;
+		// Buttons that went down or up since the last update, so a press or release that is shorter than a frame is not lost
+		volatile int64 PressLatch;
+		volatile int64 ReleaseLatch;
+		// State that was last send to Slate, only used on the game thread
+		int64 Dispatched;
+		// Buttons that are consumed by a virtual device and do not send events, only used on the game thread
+		int64 Muted;
+	};
+	static const int32 ButtonsPerWord = 64;
+
+	// Allocated when the config is parsed, the number of buttons does not change after that
+	TArray<ButtonWord> ButtonWords;
+
+	// Number of times a button went down and up, indexed by slot.
+	// The latches are cleared by every update, so these are what tells a replica about a press that started and ended within a frame of the primary.
+	struct ButtonEdges
+	{
+		volatile int32 Presses;
+		volatile int32 Releases;
 	};
+	TArray<ButtonEdges> ButtonEdgeCounts;
+	// Replicas only use the edge counts after the first snapshot, before that they do not know the previous counts
+	bool bReceivedClusterState;
+	// Edges of each button that were send or dropped, compared with the edge counts to find the dropped events. Only used on the game thread
+	TArray<int32> HandledEdgeCounts;
+	int64 NumDroppedEvents;
 
-	TArray<KeyEventPair> KeyPressStack;
+	// Sets the state bit and the press or release latch of a button and counts the edge
+	void SetButtonState(int32 Slot, bool bPressed);
+	bool IsSlotPressed(int32 Slot) const;
+	void SendButtonEvent(int32 Slot, bool bPressed, const FModifierKeysState &ModifierKeys) const;
+
+	// Passes the samples from the sample source to HandleButtonDevice
+	void PollSampleSource();
+
+	void SerializeDeviceConfig(FArchive &Ar) override;
+	// Returns false when the id is out of range
+	bool AddButton(int32 ButtonId, const FKey &Key);
 
 	vrpn_Button_Remote *InputDevice;
 
 	static void VRPN_CALLBACK HandleButtonDevice(void *userData, vrpn_BUTTONCB const b);
 
-	TMap<int32, const FKey> ButtonMap;
+	// Slot of each button id, the arrays below are indexed by slot
+	TArray<int32> ButtonSlots;
+	// Only used when the events are send
+	TArray<FKey> ButtonKeys;
+	TArray<int32> ButtonIds;
+	// Local time of the last report, zero if unknown, guarded by StateCritSect
+	double SampleTime;
 };
 
 /*
 * Connects to a VRPN tracker device.
 * each time update is called it will refresh it's value with the latest.
 */
-class VRPNTrackerInputDevice : public IVRPNInputDevice, public IMotionController
+class VRPNTrackerInputDevice : public IVRPNInputDevice
 {
 public:
 	/* If a device is not enabled it will still add the blueprints functions but it does not establish a VRPN connection.
@@ -96,39 +349,73 @@ public:
 
 	void Update() override;
 	bool ParseConfig(FConfigSection *InConfigSection) override;
+	void SerializeClusterState(FArchive &Ar) override;
+	vrpn_BaseClass* GetRemote() const override { return InputDevice; }
+
+	/*
+	 * Adds the trackers that have a PlayerId to the motion controller of the plugin.
+	 */
+	void RegisterMotionControllers(FVRPNMotionController &MotionController);
 
-	// IMotionController overrides
-	virtual bool GetControllerOrientationAndPosition(const int32 ControllerIndex, const EControllerHand DeviceHand, FRotator& OutOrientation, FVector& OutPosition) const override;
+	/*
+	 * Gets the latest received pose of a tracker in UE4 coordinates, this is used by the motion controller and can be called from the render thread.
+	 * It never polls VRPN itself, so the render thread does not wait for the network.
+	 */
+	bool GetTrackerPose(int32 TrackerId, FRotator &OutOrientation, FVector &OutPosition) const;
 
-	virtual ETrackingStatus GetControllerTrackingStatus(const int32 ControllerIndex, const EControllerHand DeviceHand) const override;
+	// The index of an axis is Slot * NumPoseAxes + Axis, the index of a pose is the slot of the tracker
+	int32 FindAxis(const FName &Name) const override;
+	float GetAxis(int32 Index) const override;
+	int32 FindPose(const FName &Name) const override;
+	bool GetPose(int32 Index, FVector &OutPosition, FQuat &OutRotation) const override;
+	void MuteAxis(int32 Index) override;
+	void MutePose(int32 Index) override;
 
 private:
-	struct TrackerInput
+	// Written for every report, kept apart from the keys so a report only touches this array
+	struct TrackerSample
 	{
-		FKey MotionXKey;
-		FKey MotionYKey;
-		FKey MotionZKey;
-
-		FKey RotationYawKey;
-		FKey RotationPitchKey;
-		FKey RotationRollKey;
-
-		FVector CurrentTrackerPosition;
 		FQuat CurrentTrackerRotation;
+		FVector CurrentTrackerPosition;
+		bool TrackerDataDirty;
+		double SampleTime; // local time of the last report, zero if unknown
+	};
+
+	// Only used when the config is parsed and when the events are send
+	struct TrackerInfo
+	{
+		// MotionX, MotionY, MotionZ, RotationYaw, RotationPitch and RotationRoll
+		FKey Keys[NumPoseAxes];
+		FName TrackerName;
+		int32 TrackerId;
 
 		// for motion controllers
 		int PlayerIndex;
 		EControllerHand Hand;
 
-		bool TrackerDataDirty;
+		// Bit N is set when the key of axis N does not send events
+		uint8 MutedAxes;
 	};
 
 	// Applies the translation and rotations offsets to the tracker coordinates
-	void TransformCoordinates(const TrackerInput &Tracker, FVector &OutPosition, FQuat &OutRotation) const;
+	void TransformCoordinates(const FVector &TrackerPosition, const FQuat &TrackerRotation, FVector &OutPosition, FQuat &OutRotation) const;
+
+	// Passes the samples from the sample source to HandleTrackerDevice
+	void PollSampleSource();
+
+	void SerializeDeviceConfig(FArchive &Ar) override;
+	// Returns the slot of the tracker or INDEX_NONE when the id is out of range
+	int32 AddTracker(int32 TrackerId, const FString &TrackerName, int PlayerIndex, EControllerHand Hand);
 
 	vrpn_Tracker_Remote *InputDevice;
 
-	TMap<int32, TrackerInput> TrackerMap;
+	// Slot of each tracker id, the slots are in config order
+	TArray<int32> TrackerSlots;
+	// Both indexed by slot
+	TArray<TrackerSample> TrackerSamples;
+	TArray<TrackerInfo> TrackerInfos;
+	// When MaxEventsPerTick is reached the next update continues at this slot
+	int32 FirstTrackerToUpdate;
 	FVector TranslationOffset;
 	FQuat RotationOffset; // This rotation will be added to the Yaw/Pitch/Roll
 	
@@ -149,14 +436,75 @@ public :
 	virtual ~VRPNAnalogInputDevice();
 	void Update() override;
 	bool ParseConfig(FConfigSection *InConfigSection) override;
+	void SerializeClusterState(FArchive &Ar) override;
+	vrpn_BaseClass* GetRemote() const override { return InputDevice; }
+
+	// The index of an axis is its channel id
+	int32 FindAxis(const FName &Name) const override;
+	float GetAxis(int32 Index) const override;
+	void MuteAxis(int32 Index) override;
 private: 
 	struct ChannelInput
 	{
 		
 	};
+	// Passes the samples from the sample source to HandleAnalogDevice
+	void PollSampleSource();
+
+	void SerializeDeviceConfig(FArchive &Ar) override;
+
 	vrpn_Analog_Remote *InputDevice;
 	vrpn_int32 num_channel;                 // how many channels
 	vrpn_float64 channels[vrpn_CHANNEL_MAX]; // analog values
-	TMap<int32, const FKey> ChannelMap;
+	double SampleTime;                      // local time of the last report, zero if unknown
+	int32 FirstChannelToUpdate;             // when MaxEventsPerTick is reached the next update continues here
+	// Key of each channel id, channels without a mapping have an invalid key
+	TArray<FKey> ChannelKeys;
+	bool MutedChannels[vrpn_CHANNEL_MAX];   // channels that do not send events, only used on the game thread
 	static void VRPN_CALLBACK HandleAnalogDevice(void *userData, vrpn_ANALOGCB const tr);
+};
+
+/*
+ * Connects to a VRPN analog output device, e.g. to drive haptics or actuators.
+ * Force feedback that the game sets for a controller is mapped to the output channels.
+ * The values are collected during the frame and send at most once per update, only when they changed more than the threshold.
+ */
+class VRPNAnalogOutputDevice : public IVRPNInputDevice
+{
+public:
+	VRPNAnalogOutputDevice(const FString &OutputAddress, FCriticalSection& InCritSect, bool bEnabled = true);
+	virtual ~VRPNAnalogOutputDevice();
+	void Update() override;
+	bool ParseConfig(FConfigSection *InConfigSection) override;
+	// The output is only driven where the device is enabled (on the primary in a cluster, replicas create it disabled), so there is no state to replicate
+	void SerializeClusterState(FArchive &Ar) override {}
+	// The output device has its own connection that is only used from the game thread, so it is never handed to a polling thread
+	vrpn_BaseClass* GetRemote() const override { return nullptr; }
+
+	/*
+	 * Sets the value for all channels that are mapped to this controller and force feedback channel.
+	 * This only stores the value, it is send in the next update.
+	 */
+	void SetForceFeedbackValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value);
+
+private:
+	void SerializeDeviceConfig(FArchive &Ar) override;
+
+	struct OutputChannel
+	{
+		int32 ChannelId;
+		int32 ControllerId;
+		FForceFeedbackChannelType ChannelType;
+	};
+	TArray<OutputChannel> OutputChannels;
+
+	vrpn_Analog_Output_Remote *OutputDevice;
+
+	vrpn_int32 NumChannels;                       // highest mapped channel + 1
+	vrpn_float64 PendingValues[vrpn_CHANNEL_MAX]; // values set during this frame
+	vrpn_float64 SentValues[vrpn_CHANNEL_MAX];    // values that were last send to the server
+
+	float ChangeThreshold;
+	double MinSendInterval;
+	double LastSendTime;
 };
\ No newline at end of file
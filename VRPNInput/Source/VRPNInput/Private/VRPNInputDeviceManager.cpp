@@ -24,6 +24,9 @@ SOFTWARE.
 
 #include "VRPNInputPrivatePCH.h"
 #include "VRPNInputDeviceManager.h"
+#include "VRPNClusterSync.h"
+#include "VRPNVirtualInputDevice.h"
+#include "VRPNConfigCache.h"
 #if PLATFORM_WINDOWS
 	#include "AllowWindowsPlatformTypes.h"
 		#include "vrpn_Tracker.h"
@@ -68,68 +71,111 @@ public:
 			UE_LOG(LogVRPNInputDevice, Log, TEXT("Loading VRPN configuration file: %s."), *ConfigFile);
 		}
 
+		// In a cluster only the primary node connects to the VRPN servers
+		FVRPNClusterSync *ClusterSync = FVRPNClusterSync::CreateFromCommandLine();
+		const bool bIsReplica = ClusterSync && ClusterSync->GetRole() == FVRPNClusterSync::ERole::Replica;
+
 		FString EnabledDevices;
 		TArray<FString> EnabledDevicesArray;
 		FParse::Value(FCommandLine::Get(), TEXT("VRPNEnabledDevices="), EnabledDevices);
 		EnabledDevices.ParseIntoArray(EnabledDevicesArray, TEXT(","), false);
-		
-		TArray<FString> SectionNames;
-		GConfig->GetSectionNames(ConfigFile,SectionNames);
-		for(FString &SectionNameString : SectionNames)
+
+		FVRPNConfigCache::FCreateDeviceFunction CreateDeviceFunction = [&](const FString &Type, const FString &SectionName, const FString &Address)
 		{
-			// Tracker name is the section name itself
-			FConfigSection* TrackerConfig = GConfig->GetSectionPrivate(*SectionNameString, false, true, ConfigFile);
+			const bool bEnabled = !bIsReplica && (EnabledDevicesArray.Num() == 0 || EnabledDevicesArray.Contains(SectionName));
+			return FVRPNInputDeviceManager::CreateDevice(Type, SectionName, Address, CritSect, bEnabled);
+		};
 
-			FConfigValue *TrackerTypeConfigValue = TrackerConfig->Find(FName(TEXT("Type")));
-			if(TrackerTypeConfigValue == nullptr)
+		// The enabled devices and the cluster role are not part of the cache, they are applied when the devices are created
+		TArray<FVRPNConfigCache::ConfiguredDevice> Devices;
+		FVRPNConfigCache ConfigCache(ConfigFile);
+		const bool bUseConfigCache = !FParse::Param(FCommandLine::Get(), TEXT("VRPNNoConfigCache"));
+		const double ConfigStartTime = FPlatformTime::Seconds();
+		if(bUseConfigCache && ConfigCache.Load(CreateDeviceFunction, Devices))
+		{
+			UE_LOG(LogVRPNInputDevice, Log, TEXT("Loaded %i VRPN devices from the config cache in %.2f ms."), Devices.Num(), (FPlatformTime::Seconds() - ConfigStartTime) * 1000.0);
+		}
+		else
+		{
+			FVRPNInputDeviceManager::ParseConfigFile(ConfigFile, CreateDeviceFunction, Devices);
+			UE_LOG(LogVRPNInputDevice, Log, TEXT("Parsed %i VRPN devices from the config file in %.2f ms."), Devices.Num(), (FPlatformTime::Seconds() - ConfigStartTime) * 1000.0);
+			if(bUseConfigCache)
 			{
-				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: expected to find Type of type String in section [%s]. Skipping this section."), *ConfigFile, *SectionNameString);
-				continue;
+				ConfigCache.Save(Devices);
 			}
-			const FString &TrackerTypeString = TrackerTypeConfigValue->GetValue();
+		}
 
-			FConfigValue *TrackerAdressConfigValue = TrackerConfig->Find(FName(TEXT("Address")));
-			if(TrackerAdressConfigValue == nullptr)
-			{
-				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: expected to find Address of type String in section [%s]. Skipping this section."), *ConfigFile, *SectionNameString);
-				continue;
-			}
-			const FString &TrackerAdressString = TrackerAdressConfigValue->GetValue();
+		for(const FVRPNConfigCache::ConfiguredDevice &Entry : Devices)
+		{
+			AddDevice(Entry);
+		}
 
-			IVRPNInputDevice *InputDevice = nullptr;
-			bool bEnabled = EnabledDevicesArray.Num() == 0 ||EnabledDevicesArray.Contains(SectionNameString);
-			if(TrackerTypeString.Compare("Tracker") == 0)
-			{
-				UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNTrackerInputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
-				InputDevice = new VRPNTrackerInputDevice(TrackerAdressString, CritSect, bEnabled);
-			} else if(TrackerTypeString.Compare("Button") == 0)
-			{
-				UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNButtonInputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
-				InputDevice = new VRPNButtonInputDevice(TrackerAdressString, CritSect, bEnabled);
-			} else if (TrackerTypeString.Compare("Analog") == 0)
+		if(DeviceManager.IsValid())
+		{
+			const double RegisterStartTime = FPlatformTime::Seconds();
+			const int32 NumKeys = DeviceManager->RegisterKeys();
+			UE_LOG(LogVRPNInputDevice, Log, TEXT("Registered %i VRPN keys in %.2f ms."), NumKeys, (FPlatformTime::Seconds() - RegisterStartTime) * 1000.0);
+
+			DeviceManager->ResolveVirtualDevices();
+
+			int32 PollingCore = INDEX_NONE;
+			FParse::Value(FCommandLine::Get(), TEXT("VRPNPollingCore="), PollingCore);
+			DeviceManager->StartPollingThreads(FVRPNPollingThread::GetPollingModeFromCommandLine(), PollingCore, CritSect);
+			DeviceManager->RegisterMotionController();
+
+			float FrameBudgetMs;
+			if(FParse::Value(FCommandLine::Get(), TEXT("VRPNFrameBudgetMs="), FrameBudgetMs))
 			{
-				UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNAnalogInputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
-				InputDevice = new VRPNAnalogInputDevice(TrackerAdressString, CritSect, bEnabled);
+				DeviceManager->SetFrameBudget(FrameBudgetMs / 1000.0);
 			}
-			else
+
+			float StatsIntervalSec;
+			if(FParse::Value(FCommandLine::Get(), TEXT("VRPNStatsIntervalSec="), StatsIntervalSec))
 			{
-				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: Type should be Tracker, Button or Analog but found %s in section %s. Skipping this section."), *ConfigFile, *TrackerTypeString, *SectionNameString);
-				continue;
+				DeviceManager->SetStatsInterval(StatsIntervalSec);
 			}
-			if(!InputDevice->ParseConfig(TrackerConfig))
+		}
+
+		if(ClusterSync)
+		{
+			if(DeviceManager.IsValid())
 			{
-				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: Could not parse config %s.."), *ConfigFile, *SectionNameString);
-				continue;
+				DeviceManager->SetClusterSync(ClusterSync);
 			}
-			if(!DeviceManager.IsValid())
+			else
 			{
-				UE_LOG(LogVRPNInputDevice, Log, TEXT("Create VRPN Input Manager."));
-				DeviceManager = TSharedPtr< FVRPNInputDeviceManager >(new FVRPNInputDeviceManager());
+				delete ClusterSync;
 			}
-			DeviceManager->AddInputDevice(InputDevice);
 		}
+	}
 
-		
+	/*
+	 * Hands a created device to the device manager.
+	 */
+	void AddDevice(const FVRPNConfigCache::ConfiguredDevice &Entry) {
+		if(!DeviceManager.IsValid())
+		{
+			UE_LOG(LogVRPNInputDevice, Log, TEXT("Create VRPN Input Manager."));
+			DeviceManager = TSharedPtr< FVRPNInputDeviceManager >(new FVRPNInputDeviceManager());
+		}
+		if(Entry.Type.Compare("Virtual") == 0)
+		{
+			DeviceManager->AddVirtualDevice(static_cast<VRPNVirtualInputDevice*>(Entry.Device));
+			return;
+		}
+		DeviceManager->AddInputDevice(Entry.Device);
+		if(Entry.Type.Compare("Tracker") == 0)
+		{
+			static_cast<VRPNTrackerInputDevice*>(Entry.Device)->RegisterMotionControllers(DeviceManager->GetMotionController());
+		}
+		else if(Entry.Type.Compare("Button") == 0)
+		{
+			DeviceManager->AddButtonDevice(static_cast<VRPNButtonInputDevice*>(Entry.Device));
+		}
+		else if(Entry.Type.Compare("AnalogOutput") == 0)
+		{
+			DeviceManager->AddForceFeedbackDevice(static_cast<VRPNAnalogOutputDevice*>(Entry.Device));
+		}
 	}
 
 	/** IPsudoControllerInterface implementation */
@@ -151,25 +197,362 @@ public:
 		return CritSect;
 	}
 
+	bool IsButtonPressed(const FString &DeviceName, int32 ButtonId) const override {
+		return DeviceManager.IsValid() && DeviceManager->IsButtonPressed(DeviceName, ButtonId);
+	}
+
 	FCriticalSection CritSect;
 	TSharedPtr< class FVRPNInputDeviceManager > DeviceManager;
 };
 
 IMPLEMENT_MODULE(FVRPNInputPlugin, VRPNInput)
 
-FVRPNInputDeviceManager::FVRPNInputDeviceManager() {
+FVRPNInputDeviceManager::FVRPNInputDeviceManager():
+FrameBudgetSeconds(0.0),
+StatsIntervalSeconds(0.0),
+LastStatsTime(FPlatformTime::Seconds()),
+FirstStatsUsedPhysical(0),
+ClusterSync(nullptr),
+bMotionControllerRegistered(false)
+{
 }
 
 FVRPNInputDeviceManager::~FVRPNInputDeviceManager() {
+	if(bMotionControllerRegistered)
+	{
+		IModularFeatures::Get().UnregisterModularFeature(IMotionController::GetModularFeatureName(), &MotionController);
+	}
+	// Stop the threads first, they call into the devices
+	for(FVRPNPollingThread* PollingThread: PollingThreads)
+	{
+		delete PollingThread;
+	}
 	for(IVRPNInputDevice* InputDevice: VRPNInputDevices)
 	{
 		delete InputDevice;
 	}
+	for(VRPNVirtualInputDevice* VirtualDevice: VirtualDevices)
+	{
+		delete VirtualDevice;
+	}
+	delete ClusterSync;
 }
 
-void FVRPNInputDeviceManager::SendControllerEvents() {
+IVRPNInputDevice* FVRPNInputDeviceManager::CreateDevice(const FString &TrackerTypeString, const FString &SectionNameString, const FString &TrackerAdressString, FCriticalSection &CritSect, bool bEnabled) {
+	IVRPNInputDevice *InputDevice = nullptr;
+	if(TrackerTypeString.Compare("Tracker") == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNTrackerInputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
+		InputDevice = new VRPNTrackerInputDevice(TrackerAdressString, CritSect, bEnabled);
+	} else if(TrackerTypeString.Compare("Button") == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNButtonInputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
+		InputDevice = new VRPNButtonInputDevice(TrackerAdressString, CritSect, bEnabled);
+	} else if (TrackerTypeString.Compare("Analog") == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNAnalogInputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
+		InputDevice = new VRPNAnalogInputDevice(TrackerAdressString, CritSect, bEnabled);
+	} else if (TrackerTypeString.Compare("AnalogOutput") == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNAnalogOutputDevice %s on adress %s."), *SectionNameString, *TrackerAdressString);
+		InputDevice = new VRPNAnalogOutputDevice(TrackerAdressString, CritSect, bEnabled);
+	} else if (TrackerTypeString.Compare("Virtual") == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Creating VRPNVirtualInputDevice %s."), *SectionNameString);
+		InputDevice = new VRPNVirtualInputDevice(CritSect);
+	}
+	if(InputDevice)
+	{
+		InputDevice->SetDeviceName(SectionNameString);
+	}
+	return InputDevice;
+}
+
+void FVRPNInputDeviceManager::ParseConfigFile(const FString &ConfigFile, const FVRPNConfigCache::FCreateDeviceFunction &CreateDeviceFunction, TArray<FVRPNConfigCache::ConfiguredDevice> &OutDevices) {
+	TArray<FString> SectionNames;
+	GConfig->GetSectionNames(ConfigFile,SectionNames);
+	for(FString &SectionNameString : SectionNames)
+	{
+		// Tracker name is the section name itself
+		FConfigSection* TrackerConfig = GConfig->GetSectionPrivate(*SectionNameString, false, true, ConfigFile);
+
+		FConfigValue *TrackerTypeConfigValue = TrackerConfig->Find(FName(TEXT("Type")));
+		if(TrackerTypeConfigValue == nullptr)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: expected to find Type of type String in section [%s]. Skipping this section."), *ConfigFile, *SectionNameString);
+			continue;
+		}
+		const FString &TrackerTypeString = TrackerTypeConfigValue->GetValue();
+
+		// Virtual devices are computed from the other devices and have no address
+		const bool bIsVirtual = TrackerTypeString.Compare("Virtual") == 0;
+		FConfigValue *TrackerAdressConfigValue = TrackerConfig->Find(FName(TEXT("Address")));
+		if(TrackerAdressConfigValue == nullptr && !bIsVirtual)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: expected to find Address of type String in section [%s]. Skipping this section."), *ConfigFile, *SectionNameString);
+			continue;
+		}
+		const FString TrackerAdressString = TrackerAdressConfigValue ? TrackerAdressConfigValue->GetValue() : FString();
+
+		IVRPNInputDevice *InputDevice = CreateDeviceFunction(TrackerTypeString, SectionNameString, TrackerAdressString);
+		if(InputDevice == nullptr)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: Type should be Tracker, Button, Analog, AnalogOutput or Virtual but found %s in section %s. Skipping this section."), *ConfigFile, *TrackerTypeString, *SectionNameString);
+			continue;
+		}
+		if(!InputDevice->ParseConfig(TrackerConfig))
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: Could not parse config %s.."), *ConfigFile, *SectionNameString);
+			delete InputDevice;
+			continue;
+		}
+		if(bIsVirtual)
+		{
+			// Virtual devices are updated every frame after the devices they read from, so they are not scheduled
+			for(const TCHAR *SchedulingKey : {TEXT("UpdateRateHz"), TEXT("Priority"), TEXT("MaxEventsPerTick")})
+			{
+				if(TrackerConfig->Find(FName(SchedulingKey)))
+				{
+					UE_LOG(LogVRPNInputDevice, Warning, TEXT("Tracker config file %s: %s is ignored in the virtual device section %s, virtual devices are updated every frame."), *ConfigFile, SchedulingKey, *SectionNameString);
+				}
+			}
+		}
+		else
+		{
+			InputDevice->ParseSchedulingConfig(TrackerConfig);
+		}
+		OutDevices.Add({InputDevice, TrackerTypeString, TrackerAdressString});
+	}
+}
+
+bool FVRPNInputDeviceManager::IsButtonPressed(const FString &DeviceName, int32 ButtonId) const {
+	for(const VRPNButtonInputDevice *ButtonDevice : ButtonDevices)
+	{
+		if(ButtonDevice->GetDeviceName() == DeviceName)
+		{
+			return ButtonDevice->IsButtonPressed(ButtonId);
+		}
+	}
+	return false;
+}
+
+void FVRPNInputDeviceManager::AddInputDevice(IVRPNInputDevice *InInputDevice) {
+	VRPNInputDevices.Add(InInputDevice);
+	UpdateSchedule.Add({InInputDevice, 0.0});
+}
+
+int32 FVRPNInputDeviceManager::RegisterKeys() {
+	int32 NumKeys = 0;
 	for(IVRPNInputDevice* InputDevice: VRPNInputDevices)
 	{
+		NumKeys += InputDevice->RegisterKeys();
+	}
+	for(VRPNVirtualInputDevice* VirtualDevice: VirtualDevices)
+	{
+		NumKeys += VirtualDevice->RegisterKeys();
+	}
+	return NumKeys;
+}
+
+void FVRPNInputDeviceManager::ResolveVirtualDevices() {
+	// Virtual devices can also use the keys of other virtual devices
+	TArray<IVRPNInputDevice*> Devices(VRPNInputDevices);
+	for(VRPNVirtualInputDevice* VirtualDevice: VirtualDevices)
+	{
+		Devices.Add(VirtualDevice);
+	}
+	for(VRPNVirtualInputDevice* VirtualDevice: VirtualDevices)
+	{
+		VirtualDevice->ResolveInputs(Devices);
+	}
+}
+
+void FVRPNInputDeviceManager::SetClusterSync(FVRPNClusterSync *InClusterSync) {
+	delete ClusterSync;
+	ClusterSync = InClusterSync;
+}
+
+void FVRPNInputDeviceManager::StartPollingThreads(EVRPNPollingMode PollingMode, int32 FirstCore, FCriticalSection &CritSect) {
+	if(PollingMode == EVRPNPollingMode::Frame)
+	{
+		return;
+	}
+
+	for(IVRPNInputDevice* InputDevice: VRPNInputDevices)
+	{
+		vrpn_BaseClass *Remote = InputDevice->GetRemote();
+		if(Remote == nullptr || Remote->connectionPtr() == nullptr)
+		{
+			continue;
+		}
+
+		FVRPNPollingThread *ConnectionThread = nullptr;
+		for(FVRPNPollingThread* PollingThread: PollingThreads)
+		{
+			if(PollingThread->GetConnection() == Remote->connectionPtr())
+			{
+				ConnectionThread = PollingThread;
+				break;
+			}
+		}
+		if(ConnectionThread == nullptr)
+		{
+			// A core of its own for every thread, busy polling threads on the same core would only take turns
+			uint64 AffinityMask = FPlatformAffinity::GetNoAffinityMask();
+			const int32 Core = FirstCore + PollingThreads.Num();
+			if(FirstCore != INDEX_NONE && FirstCore >= 0 && Core < FMath::Min(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 64))
+			{
+				AffinityMask = uint64(1) << Core;
+			}
+			else if(FirstCore != INDEX_NONE)
+			{
+				UE_LOG(LogVRPNInputDevice, Warning, TEXT("There is no core %i for VRPN polling thread %i, it is not pinned to a core."), Core, PollingThreads.Num());
+			}
+			ConnectionThread = new FVRPNPollingThread(Remote->connectionPtr(), CritSect, PollingMode, AffinityMask);
+			PollingThreads.Add(ConnectionThread);
+		}
+		ConnectionThread->AddDevice(InputDevice);
+	}
+
+	for(int32 ThreadIndex = 0; ThreadIndex < PollingThreads.Num(); ++ThreadIndex)
+	{
+		PollingThreads[ThreadIndex]->StartThread(FString::Printf(TEXT("VRPNPollingThread%i"), ThreadIndex));
+	}
+	UE_LOG(LogVRPNInputDevice, Log, TEXT("Started %i VRPN polling threads."), PollingThreads.Num());
+}
+
+void FVRPNInputDeviceManager::RegisterMotionController() {
+	if(MotionController.HasControllers() && !bMotionControllerRegistered)
+	{
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Adding VRPN trackers to the motion controller devices."));
+		IModularFeatures::Get().RegisterModularFeature(IMotionController::GetModularFeatureName(), &MotionController);
+		bMotionControllerRegistered = true;
+	}
+}
+
+bool FVRPNInputDeviceManager::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) {
+	if(!FParse::Command(&Cmd, TEXT("VRPN")))
+	{
+		return false;
+	}
+	if(FParse::Command(&Cmd, TEXT("RECEIVEAGE")))
+	{
+		Ar.Logf(TEXT("The clock offsets are one-way estimates, they include the smallest network delay. The receive ages leave it out, they are not end-to-end latencies."));
+		for(IVRPNInputDevice* InputDevice: VRPNInputDevices)
+		{
+			InputDevice->DumpReceiveAgeStats(Ar);
+		}
+		return true;
+	}
+	if(FParse::Command(&Cmd, TEXT("STATS")))
+	{
+		DumpStats(Ar);
+		return true;
+	}
+	return false;
+}
+
+int64 FVRPNInputDeviceManager::DumpStats(FOutputDevice &Ar) {
+	const double CurrentTime = FPlatformTime::Seconds();
+	const double ElapsedSeconds = CurrentTime - LastStatsTime;
+	LastStatsTime = CurrentTime;
+
+	int64 NumLosses = 0;
+	for(IVRPNInputDevice* InputDevice: VRPNInputDevices)
+	{
+		NumLosses += InputDevice->DumpStats(Ar, ElapsedSeconds);
+	}
+	for(VRPNVirtualInputDevice* VirtualDevice: VirtualDevices)
+	{
+		NumLosses += VirtualDevice->DumpStats(Ar, ElapsedSeconds);
+	}
+
+	// This is the memory of the whole process, the plugin itself does not allocate after startup
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	if(FirstStatsUsedPhysical == 0)
+	{
+		FirstStatsUsedPhysical = MemoryStats.UsedPhysical;
+	}
+	Ar.Logf(TEXT("VRPN statistics over %.1f s: process uses %.1f MB physical and %.1f MB virtual memory, %+.1f MB physical since the first statistics."),
+		ElapsedSeconds, MemoryStats.UsedPhysical / (1024.0 * 1024.0), MemoryStats.UsedVirtual / (1024.0 * 1024.0),
+		(static_cast<double>(MemoryStats.UsedPhysical) - static_cast<double>(FirstStatsUsedPhysical)) / (1024.0 * 1024.0));
+	return NumLosses;
+}
+
+void FVRPNInputDeviceManager::SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value) {
+	// Only stores the value, the output devices send the values of this frame in their next update
+	for(VRPNAnalogOutputDevice* OutputDevice: ForceFeedbackDevices)
+	{
+		OutputDevice->SetForceFeedbackValue(ControllerId, ChannelType, Value);
+	}
+}
+
+void FVRPNInputDeviceManager::SetChannelValues(int32 ControllerId, const FForceFeedbackValues &values) {
+	SetChannelValue(ControllerId, FForceFeedbackChannelType::LEFT_LARGE, values.LeftLarge);
+	SetChannelValue(ControllerId, FForceFeedbackChannelType::LEFT_SMALL, values.LeftSmall);
+	SetChannelValue(ControllerId, FForceFeedbackChannelType::RIGHT_LARGE, values.RightLarge);
+	SetChannelValue(ControllerId, FForceFeedbackChannelType::RIGHT_SMALL, values.RightSmall);
+}
+
+void FVRPNInputDeviceManager::SendControllerEvents() {
+	if(ClusterSync && ClusterSync->GetRole() == FVRPNClusterSync::ERole::Replica)
+	{
+		ClusterSync->ReceiveState(VRPNInputDevices);
+	}
+
+	UpdateSchedule.Sort([](const ScheduledDevice &A, const ScheduledDevice &B) {
+		if(A.Device->GetPriority() != B.Device->GetPriority())
+		{
+			return A.Device->GetPriority() > B.Device->GetPriority();
+		}
+		return A.LastUpdateTime < B.LastUpdateTime;
+	});
+
+	const double FrameStartTime = FPlatformTime::Seconds();
+	for(ScheduledDevice &Scheduled : UpdateSchedule)
+	{
+		IVRPNInputDevice *InputDevice = Scheduled.Device;
+		const double CurrentTime = FPlatformTime::Seconds();
+		const double UpdateInterval = InputDevice->GetUpdateInterval();
+		if(CurrentTime - Scheduled.LastUpdateTime < UpdateInterval)
+		{
+			continue;
+		}
+		if(FrameBudgetSeconds > 0.0 && InputDevice->GetPriority() != EVRPNDevicePriority::High && CurrentTime - FrameStartTime > FrameBudgetSeconds)
+		{
+			// Postponed, it will be one of the first of its priority next frame because it waited longest
+			continue;
+		}
 		InputDevice->Update();
+		// Advancing by the interval keeps the average rate at UpdateRateHz instead of rounding it down to a whole number of frames.
+		// After a stall or a postponed update the schedule restarts from now instead of catching up with a burst of updates.
+		Scheduled.LastUpdateTime += UpdateInterval;
+		if(UpdateInterval <= 0.0 || CurrentTime - Scheduled.LastUpdateTime >= UpdateInterval)
+		{
+			Scheduled.LastUpdateTime = CurrentTime;
+		}
+		InputDevice->AddUpdateTime(FPlatformTime::Seconds() - CurrentTime);
+	}
+
+	// After the other devices so the virtual devices see the values of this frame
+	for(VRPNVirtualInputDevice* VirtualDevice: VirtualDevices)
+	{
+		const double UpdateStartTime = FPlatformTime::Seconds();
+		VirtualDevice->Update();
+		VirtualDevice->AddUpdateTime(FPlatformTime::Seconds() - UpdateStartTime);
+	}
+
+	if(StatsIntervalSeconds > 0.0 && FPlatformTime::Seconds() - LastStatsTime >= StatsIntervalSeconds)
+	{
+		const int64 NumLosses = DumpStats(*GLog);
+		if(NumLosses > 0)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("%lld VRPN samples or events were lost in the last %.0f seconds."), NumLosses, StatsIntervalSeconds);
+		}
+	}
+
+	if(ClusterSync && ClusterSync->GetRole() == FVRPNClusterSync::ERole::Primary)
+	{
+		ClusterSync->SendState(VRPNInputDevices);
 	}
 }
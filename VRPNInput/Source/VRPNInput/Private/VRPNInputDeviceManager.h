@@ -26,6 +26,12 @@ SOFTWARE.
 
 #include "IInputDevice.h"
 #include "VRPNInputDevice.h"
+#include "VRPNConfigCache.h"
+#include "VRPNPollingThread.h"
+#include "VRPNMotionController.h"
+
+class FVRPNClusterSync;
+class VRPNVirtualInputDevice;
 
 /**
 * Interface class for WiiInput devices (wii devices)
@@ -45,19 +51,119 @@ public:
 	virtual void SetMessageHandler(const TSharedRef< FGenericApplicationMessageHandler >& InMessageHandler) override { }
 
 	/** Exec handler to allow console commands to be passed through for debugging */
-	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override { return true; }
+	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override;
 
 	// IForceFeedbackSystem pass through functions
-	virtual void SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value) override {}
-	virtual void SetChannelValues(int32 ControllerId, const FForceFeedbackValues &values) override {}
+	virtual void SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value) override;
+	virtual void SetChannelValues(int32 ControllerId, const FForceFeedbackValues &values) override;
 
 	virtual ~FVRPNInputDeviceManager();
 
+	/*
+	 * Creates an empty device of the given type, returns nullptr when the type is unknown.
+	 * If a device is not enabled it will still add the blueprints functions but it does not establish a VRPN connection.
+	 */
+	static IVRPNInputDevice* CreateDevice(const FString &TrackerTypeString, const FString &SectionNameString, const FString &TrackerAdressString, FCriticalSection &CritSect, bool bEnabled);
+
+	/*
+	 * Creates a device for every section of the config file.
+	 */
+	static void ParseConfigFile(const FString &ConfigFile, const FVRPNConfigCache::FCreateDeviceFunction &CreateDeviceFunction, TArray<FVRPNConfigCache::ConfiguredDevice> &OutDevices);
+
 	/*
 	 * Adds input device, also transfers ownership of the device to this class.
 	 */
-	void AddInputDevice(IVRPNInputDevice *InInputDevice) { VRPNInputDevices.Add(InInputDevice); }
+	void AddInputDevice(IVRPNInputDevice *InInputDevice);
+
+	/*
+	 * Adds an output device that receives the force feedback values, the device should also be added with AddInputDevice.
+	 */
+	void AddForceFeedbackDevice(VRPNAnalogOutputDevice *InOutputDevice) { ForceFeedbackDevices.Add(InOutputDevice); }
+
+	/*
+	 * Makes the buttons of the device available to IsButtonPressed(), the device should also be added with AddInputDevice.
+	 */
+	void AddButtonDevice(VRPNButtonInputDevice *InButtonDevice) { ButtonDevices.Add(InButtonDevice); }
+
+	/*
+	 * Returns the latest received state of a button of the button device with the given name (the section name in the config).
+	 * This does not lock and can be called from any thread once all devices are added.
+	 */
+	bool IsButtonPressed(const FString &DeviceName, int32 ButtonId) const;
+
+	/*
+	 * Adds a virtual device, also transfers ownership of the device to this class.
+	 * Virtual devices are evaluated every frame after the other devices are updated.
+	 */
+	void AddVirtualDevice(VRPNVirtualInputDevice *InVirtualDevice) { VirtualDevices.Add(InVirtualDevice); }
+
+	/*
+	 * Registers the keys of all devices with EKeys in a single pass, call this after all devices are added.
+	 * Returns the number of keys.
+	 */
+	int32 RegisterKeys();
+
+	/*
+	 * Looks up the inputs of the virtual devices, call this after all devices are added.
+	 */
+	void ResolveVirtualDevices();
+
+	/*
+	 * Devices with a priority lower than High are postponed to the next frame when updating the devices
+	 * took longer than this. Zero means no budget.
+	 */
+	void SetFrameBudget(double InFrameBudgetSeconds) { FrameBudgetSeconds = InFrameBudgetSeconds; }
+
+	/*
+	 * Logs the statistics of VRPN STATS every InStatsIntervalSeconds, with a warning when samples were lost.
+	 * This is meant for soak tests and long running installations. Zero means never.
+	 */
+	void SetStatsInterval(double InStatsIntervalSeconds) { StatsIntervalSeconds = InStatsIntervalSeconds; }
+
+	/*
+	 * Makes this node part of a cluster, also transfers ownership of the cluster sync to this class.
+	 */
+	void SetClusterSync(FVRPNClusterSync *InClusterSync);
+
+	/*
+	 * Starts a polling thread for each VRPN connection, call this after all devices are added.
+	 * The threads hold CritSect while they call mainloop() of the remotes. Does nothing in the Frame polling mode.
+	 * When FirstCore is not INDEX_NONE the threads are pinned to the cores FirstCore, FirstCore + 1 and so on, so busy polling threads do not share a core.
+	 */
+	void StartPollingThreads(EVRPNPollingMode PollingMode, int32 FirstCore, FCriticalSection &CritSect);
+
+	/*
+	 * All trackers that are used as motion controllers are added to this motion controller.
+	 * Call RegisterMotionController() after the devices are added.
+	 */
+	FVRPNMotionController& GetMotionController() { return MotionController; }
+	void RegisterMotionController();
 
 private:
 	TArray<IVRPNInputDevice*> VRPNInputDevices;
+	TArray<FVRPNPollingThread*> PollingThreads;
+	TArray<VRPNAnalogOutputDevice*> ForceFeedbackDevices;
+	TArray<VRPNButtonInputDevice*> ButtonDevices;
+	TArray<VRPNVirtualInputDevice*> VirtualDevices;
+
+	struct ScheduledDevice
+	{
+		IVRPNInputDevice *Device;
+		double LastUpdateTime;
+	};
+	// The devices in the order they are updated, highest priority first and within a priority the one that waited longest
+	TArray<ScheduledDevice> UpdateSchedule;
+	double FrameBudgetSeconds;
+
+	// Prints the statistics of every device and the memory use of the process, returns the number of lost samples and dropped events
+	int64 DumpStats(FOutputDevice &Ar);
+	double StatsIntervalSeconds;
+	double LastStatsTime;
+	// Memory use when the statistics were first printed, the growth is reported relative to this
+	uint64 FirstStatsUsedPhysical;
+
+	FVRPNClusterSync *ClusterSync;
+
+	FVRPNMotionController MotionController;
+	bool bMotionControllerRegistered;
 };
\ No newline at end of file
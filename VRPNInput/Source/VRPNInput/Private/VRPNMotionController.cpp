@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNMotionController.h"
+#include "VRPNInputDevice.h"
+
+FVRPNMotionController::FVRPNMotionController():
+NumControllers(0)
+{
+}
+
+void FVRPNMotionController::AddController(int32 PlayerIndex, EControllerHand Hand, VRPNTrackerInputDevice *Device, int32 TrackerId)
+{
+	const int32 HandIndex = static_cast<int32>(Hand);
+	if(PlayerIndex < 0 || HandIndex < 0 || HandIndex >= NumHands)
+	{
+		return;
+	}
+	if(PlayerIndex >= MaxPlayers)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("PlayerId %i of tracker %i is too large, at most %i players can have a motion controller. The tracker is not used as a motion controller."), PlayerIndex, TrackerId, MaxPlayers);
+		return;
+	}
+
+	const int32 EntryIndex = PlayerIndex * NumHands + HandIndex;
+	if(EntryIndex >= Controllers.Num())
+	{
+		Controllers.AddZeroed(EntryIndex + 1 - Controllers.Num());
+	}
+
+	ControllerEntry &Entry = Controllers[EntryIndex];
+	if(Entry.Device)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("There is already a motion controller for player %i and this hand, tracker %i is ignored."), PlayerIndex, TrackerId);
+		return;
+	}
+	Entry.Device = Device;
+	Entry.TrackerId = TrackerId;
+	++NumControllers;
+}
+
+const FVRPNMotionController::ControllerEntry* FVRPNMotionController::FindController(int32 ControllerIndex, EControllerHand DeviceHand) const
+{
+	const int32 HandIndex = static_cast<int32>(DeviceHand);
+	if(ControllerIndex < 0 || HandIndex < 0 || HandIndex >= NumHands)
+	{
+		return nullptr;
+	}
+
+	const int32 EntryIndex = ControllerIndex * NumHands + HandIndex;
+	if(EntryIndex >= Controllers.Num() || Controllers[EntryIndex].Device == nullptr)
+	{
+		return nullptr;
+	}
+	return &Controllers[EntryIndex];
+}
+
+bool FVRPNMotionController::GetControllerOrientationAndPosition(const int32 ControllerIndex, const EControllerHand DeviceHand, FRotator& OutOrientation, FVector& OutPosition) const
+{
+	const ControllerEntry *Entry = FindController(ControllerIndex, DeviceHand);
+	if(Entry == nullptr)
+	{
+		return false;
+	}
+	return Entry->Device->GetTrackerPose(Entry->TrackerId, OutOrientation, OutPosition);
+}
+
+// for now always return tracked, need to see later if we can return better information
+ETrackingStatus FVRPNMotionController::GetControllerTrackingStatus(const int32 ControllerIndex, const EControllerHand DeviceHand) const
+{
+	return FindController(ControllerIndex, DeviceHand) ? ETrackingStatus::Tracked : ETrackingStatus::NotTracked;
+}
@@ -0,0 +1,67 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "IMotionController.h"
+
+class VRPNTrackerInputDevice;
+
+/*
+ * The single motion controller of the plugin.
+ * Every tracker with a PlayerId is put in a flat table indexed by (PlayerIndex, Hand) when the config is parsed,
+ * so a query is a single lookup instead of asking every tracker device in turn.
+ */
+class FVRPNMotionController : public IMotionController
+{
+public:
+	FVRPNMotionController();
+
+	void AddController(int32 PlayerIndex, EControllerHand Hand, VRPNTrackerInputDevice *Device, int32 TrackerId);
+	bool HasControllers() const { return NumControllers > 0; }
+
+	// IMotionController overrides
+	virtual bool GetControllerOrientationAndPosition(const int32 ControllerIndex, const EControllerHand DeviceHand, FRotator& OutOrientation, FVector& OutPosition) const override;
+
+	virtual ETrackingStatus GetControllerTrackingStatus(const int32 ControllerIndex, const EControllerHand DeviceHand) const override;
+
+private:
+	struct ControllerEntry
+	{
+		VRPNTrackerInputDevice *Device;
+		int32 TrackerId;
+	};
+
+	// Returns nullptr if no tracker is configured for this player and hand
+	const ControllerEntry* FindController(int32 ControllerIndex, EControllerHand DeviceHand) const;
+
+	// Only the left and right hand can be configured
+	static const int32 NumHands = 2;
+	// Bounds the table, a larger PlayerId in the config is rejected
+	static const int32 MaxPlayers = 8;
+
+	// Indexed by PlayerIndex * NumHands + Hand
+	TArray<ControllerEntry> Controllers;
+	int32 NumControllers;
+};
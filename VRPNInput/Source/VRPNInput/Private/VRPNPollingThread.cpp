@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNPollingThread.h"
+
+namespace
+{
+	// How long mainloop() waits for data in event mode. Data wakes the thread immediately, so this only bounds how long stopping the thread takes
+	const long EventWaitMicroseconds = 10000;
+}
+
+FVRPNPollingThread::FVRPNPollingThread(vrpn_Connection *InConnection, FCriticalSection &InCritSect, EVRPNPollingMode InPollingMode, uint64 InAffinityMask):
+Connection(InConnection),
+CritSect(InCritSect),
+PollingMode(InPollingMode),
+AffinityMask(InAffinityMask),
+Thread(nullptr)
+{
+}
+
+FVRPNPollingThread::~FVRPNPollingThread()
+{
+	if(Thread)
+	{
+		Thread->Kill(/*bShouldWait=*/true);
+		delete Thread;
+	}
+}
+
+void FVRPNPollingThread::AddDevice(IVRPNInputDevice *InDevice)
+{
+	check(Thread == nullptr);
+	Remotes.Add(InDevice->GetRemote());
+	InDevice->SetPolledExternally(true);
+}
+
+void FVRPNPollingThread::StartThread(const FString &ThreadName)
+{
+	const EThreadPriority Priority = PollingMode == EVRPNPollingMode::BusyPoll ? TPri_Highest : TPri_AboveNormal;
+	Thread = FRunnableThread::Create(this, *ThreadName, 0, Priority, AffinityMask);
+}
+
+uint32 FVRPNPollingThread::Run()
+{
+	while(StopCounter.GetValue() == 0)
+	{
+		// The devices of this connection do not call mainloop() themselves in this mode, so this thread is the only one that reads the connection
+		// and can wait for data without the VRPN lock. The other threads would otherwise wait for the lock, and the connections for each other.
+		bool bConnected = true;
+		if(PollingMode == EVRPNPollingMode::Event)
+		{
+			bConnected = Connection->connected() != 0;
+			if(bConnected)
+			{
+				// Blocks in select() on the sockets of the connection until a report arrives, the callbacks run from here
+				timeval Timeout;
+				Timeout.tv_sec = 0;
+				Timeout.tv_usec = EventWaitMicroseconds;
+				Connection->mainloop(&Timeout);
+			}
+		}
+
+		{
+			// Handles what arrived since and the pings of the remotes, this does not wait
+			FScopeLock ScopeLock(&CritSect);
+			for(vrpn_BaseClass *Remote : Remotes)
+			{
+				Remote->mainloop();
+			}
+		}
+
+		if(!bConnected)
+		{
+			// While VRPN is (re)connecting mainloop() returns immediately
+			FPlatformProcess::Sleep(EventWaitMicroseconds / 1000000.0f);
+		}
+		else if(PollingMode == EVRPNPollingMode::BusyPoll)
+		{
+			// Gives the threads that wait for the lock a chance to take it
+			FPlatformProcess::Sleep(0.0f);
+		}
+	}
+	return 0;
+}
+
+void FVRPNPollingThread::Stop()
+{
+	StopCounter.Increment();
+}
+
+EVRPNPollingMode FVRPNPollingThread::GetPollingModeFromCommandLine()
+{
+	FString PollingModeString;
+	if(FParse::Value(FCommandLine::Get(), TEXT("VRPNPollingMode="), PollingModeString))
+	{
+		if(PollingModeString.Equals(TEXT("Event")))
+		{
+			return EVRPNPollingMode::Event;
+		}
+		if(PollingModeString.Equals(TEXT("BusyPoll")))
+		{
+			return EVRPNPollingMode::BusyPoll;
+		}
+		if(!PollingModeString.Equals(TEXT("Frame")))
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("VRPNPollingMode should be Frame, Event or BusyPoll but found %s. Using Frame."), *PollingModeString);
+		}
+	}
+	return EVRPNPollingMode::Frame;
+}
@@ -0,0 +1,79 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNInputDevice.h"
+
+/*
+ * How the VRPN connections are polled.
+ * Frame: every device calls mainloop() once per frame (and motion controllers again when they are queried).
+ * Event: a thread per connection waits until the connection has data and only then calls mainloop().
+ * BusyPoll: a thread per connection keeps calling mainloop() without waiting, for the lowest latency.
+ *           Use -VRPNPollingCore=N to pin these threads to cores that are not used by the engine, each thread gets its own core from N up.
+ */
+enum class EVRPNPollingMode
+{
+	Frame,
+	Event,
+	BusyPoll
+};
+
+/*
+ * Polls a single VRPN connection and the devices that use it.
+ * VRPN merges remotes that use the same address into one connection, so all those devices share one thread.
+ */
+class FVRPNPollingThread : public FRunnable
+{
+public:
+	/*
+	 * The thread holds InCritSect (the lock of IVRPNInputPlugin::GetVRPNLock()) when it calls mainloop() of the remotes.
+	 * In Event mode it waits for data in mainloop() of the connection without the lock, nothing else reads that connection in this mode.
+	 */
+	FVRPNPollingThread(vrpn_Connection *InConnection, FCriticalSection &InCritSect, EVRPNPollingMode InPollingMode, uint64 InAffinityMask);
+	virtual ~FVRPNPollingThread();
+
+	/* Only the devices that are added before the thread is started are polled. */
+	void AddDevice(IVRPNInputDevice *InDevice);
+	void StartThread(const FString &ThreadName);
+
+	vrpn_Connection* GetConnection() const { return Connection; }
+
+	// FRunnable overrides
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	/* Reads the polling mode from -VRPNPollingMode=Frame|Event|BusyPoll, the default is Frame. */
+	static EVRPNPollingMode GetPollingModeFromCommandLine();
+
+private:
+	vrpn_Connection *Connection;
+	FCriticalSection &CritSect;
+	TArray<vrpn_BaseClass*> Remotes;
+	EVRPNPollingMode PollingMode;
+	uint64 AffinityMask;
+
+	FRunnableThread *Thread;
+	FThreadSafeCounter StopCounter;
+};
@@ -0,0 +1,253 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNSharedMemory.h"
+
+namespace
+{
+	const TCHAR *SharedMemoryScheme = TEXT("shm://");
+	const double OpenRetryInterval = 1.0;
+}
+
+bool FVRPNSharedMemoryReader::IsSharedMemoryAddress(const FString &Address)
+{
+	return Address.StartsWith(SharedMemoryScheme);
+}
+
+FVRPNSharedMemoryReader::FVRPNSharedMemoryReader(const FString &Address):
+RegionName(Address.RightChop(FCString::Strlen(SharedMemoryScheme))),
+Region(nullptr),
+Header(nullptr),
+Samples(nullptr),
+Session(0),
+ReadCount(0),
+NumLostSamples(0),
+LastOpenAttemptTime(0.0),
+bWarnedInvalidHeader(false)
+{
+	if(!TryOpen(false))
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not open VRPN shared memory region %s, will retry until the bridge is started."), *RegionName);
+	}
+}
+
+FVRPNSharedMemoryReader::~FVRPNSharedMemoryReader()
+{
+	Close();
+}
+
+void FVRPNSharedMemoryReader::Close()
+{
+	if(Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	}
+	Region = nullptr;
+	Header = nullptr;
+	Samples = nullptr;
+}
+
+bool FVRPNSharedMemoryReader::ReadRegionHeader(FVRPNSharedMemoryHeader &OutHeader) const
+{
+	FPlatformMemory::FSharedMemoryRegion *HeaderRegion = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, false, static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Read), sizeof(FVRPNSharedMemoryHeader));
+	if(HeaderRegion == nullptr)
+	{
+		return false;
+	}
+	FMemory::Memcpy(&OutHeader, HeaderRegion->GetAddress(), sizeof(FVRPNSharedMemoryHeader));
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(HeaderRegion);
+	return true;
+}
+
+bool FVRPNSharedMemoryReader::TryOpen(bool bFromStart)
+{
+	LastOpenAttemptTime = FPlatformTime::Seconds();
+
+	// Map the header first to find out how large the ring is
+	FVRPNSharedMemoryHeader RegionHeader;
+	if(!ReadRegionHeader(RegionHeader))
+	{
+		return false;
+	}
+	const uint32 Magic = RegionHeader.Magic;
+	const uint32 Version = RegionHeader.Version;
+	const uint32 Capacity = RegionHeader.Capacity;
+
+	if(Magic != VRPN_SHARED_MEMORY_MAGIC || Version != VRPN_SHARED_MEMORY_VERSION || Capacity == 0)
+	{
+		// The bridge may have created the region without writing the header yet, this is retried every second
+		if(!bWarnedInvalidHeader)
+		{
+			bWarnedInvalidHeader = true;
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("VRPN shared memory region %s has an unexpected header (version %u, capacity %u), will retry until the bridge has written it."), *RegionName, Version, Capacity);
+		}
+		return false;
+	}
+
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, false, static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Read), sizeof(FVRPNSharedMemoryHeader) + Capacity * sizeof(FVRPNSharedMemorySample));
+	if(Region == nullptr)
+	{
+		return false;
+	}
+	Header = reinterpret_cast<const FVRPNSharedMemoryHeader*>(Region->GetAddress());
+	Samples = reinterpret_cast<const FVRPNSharedMemorySample*>(Header + 1);
+	Session = Header->Session;
+
+	// Start with the newest samples, the old ones are not interesting anymore. After a restart of the bridge everything it wrote is new.
+	const int64 WriteCount = Header->WriteCount;
+	ReadCount = bFromStart ? FMath::Max<int64>(WriteCount - Capacity, 0) : FMath::Max<int64>(WriteCount - 1, 0);
+	UE_LOG(LogVRPNInputDevice, Log, TEXT("Opened VRPN shared memory region %s with %u samples."), *RegionName, Capacity);
+	return true;
+}
+
+bool FVRPNSharedMemoryReader::CheckSession(int64 WriteCount)
+{
+	// A bridge that restarts in the same mapping (Windows keeps it while we have it open) writes a new session or starts counting from zero
+	bool bRestarted = Header->Magic != VRPN_SHARED_MEMORY_MAGIC || Header->Session != Session || WriteCount < ReadCount;
+	if(!bRestarted && WriteCount == ReadCount && FPlatformTime::Seconds() - LastOpenAttemptTime >= OpenRetryInterval)
+	{
+		// A region that was removed and created again (POSIX) is a new region, the old mapping never changes again.
+		// While nothing arrives the header of the region with our name is checked every second.
+		LastOpenAttemptTime = FPlatformTime::Seconds();
+		FVRPNSharedMemoryHeader RegionHeader;
+		bRestarted = ReadRegionHeader(RegionHeader) && RegionHeader.Magic == VRPN_SHARED_MEMORY_MAGIC && RegionHeader.Session != Session;
+	}
+	if(!bRestarted)
+	{
+		return true;
+	}
+
+	UE_LOG(LogVRPNInputDevice, Log, TEXT("The bridge of VRPN shared memory region %s was restarted, opening it again."), *RegionName);
+	Close();
+	return TryOpen(true);
+}
+
+int32 FVRPNSharedMemoryReader::Poll(FVRPNSharedMemorySample *OutSamples, int32 MaxSamples)
+{
+	if(Header == nullptr)
+	{
+		if(FPlatformTime::Seconds() - LastOpenAttemptTime < OpenRetryInterval || !TryOpen(Session != 0))
+		{
+			return 0;
+		}
+	}
+	if(!CheckSession(Header->WriteCount))
+	{
+		return 0;
+	}
+
+	const int64 Capacity = Header->Capacity;
+	const int64 WriteCount = Header->WriteCount;
+	FPlatformMisc::MemoryBarrier();
+
+	if(WriteCount - ReadCount > Capacity)
+	{
+		// The bridge has lapped us
+		NumLostSamples += WriteCount - Capacity - ReadCount;
+		ReadCount = WriteCount - Capacity;
+	}
+
+	int32 NumSamples = 0;
+	while(ReadCount < WriteCount && NumSamples < MaxSamples)
+	{
+		const FVRPNSharedMemorySample &Slot = Samples[ReadCount % Capacity];
+		const int64 SequenceBefore = Slot.Sequence;
+		FPlatformMisc::MemoryBarrier();
+		FMemory::Memcpy(&OutSamples[NumSamples], &Slot, sizeof(FVRPNSharedMemorySample));
+		FPlatformMisc::MemoryBarrier();
+		const int64 SequenceAfter = Slot.Sequence;
+
+		// If the sequence changed the bridge overwrote the slot while we were copying it
+		if(SequenceBefore == ReadCount + 1 && SequenceAfter == SequenceBefore)
+		{
+			++NumSamples;
+		}
+		else
+		{
+			++NumLostSamples;
+		}
+		++ReadCount;
+	}
+	return NumSamples;
+}
+
+FVRPNSharedMemoryWriter::FVRPNSharedMemoryWriter(const FString &Name, uint32 InCapacity):
+Region(nullptr),
+Header(nullptr),
+Samples(nullptr),
+Capacity(FMath::Max<uint32>(InCapacity, 1))
+{
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, true, static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Read) | static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Write),
+		sizeof(FVRPNSharedMemoryHeader) + Capacity * sizeof(FVRPNSharedMemorySample));
+	if(Region == nullptr)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Could not create VRPN shared memory region %s."), *Name);
+		return;
+	}
+	Header = reinterpret_cast<FVRPNSharedMemoryHeader*>(Region->GetAddress());
+	Samples = reinterpret_cast<FVRPNSharedMemorySample*>(Header + 1);
+	FMemory::Memzero(Region->GetAddress(), Region->GetSize());
+
+	// The magic is written last, a reader that sees it also sees the rest of the header
+	Header->Version = VRPN_SHARED_MEMORY_VERSION;
+	Header->Capacity = Capacity;
+	Header->Session = (static_cast<uint32>(FPlatformTime::Cycles()) ^ (FPlatformProcess::GetCurrentProcessId() << 16)) | 1;
+	Header->WriteCount = 0;
+	FPlatformMisc::MemoryBarrier();
+	Header->Magic = VRPN_SHARED_MEMORY_MAGIC;
+	FPlatformMisc::MemoryBarrier();
+}
+
+FVRPNSharedMemoryWriter::~FVRPNSharedMemoryWriter()
+{
+	if(Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	}
+}
+
+void FVRPNSharedMemoryWriter::Write(EVRPNSharedMemorySampleType Type, int32 Sensor, double Time, const double *Data, int32 NumData)
+{
+	if(Header == nullptr)
+	{
+		return;
+	}
+
+	const int64 SampleIndex = Header->WriteCount;
+	FVRPNSharedMemorySample &Slot = Samples[SampleIndex % Capacity];
+	Slot.Sequence = 0;
+	FPlatformMisc::MemoryBarrier();
+
+	Slot.Type = Type;
+	Slot.Sensor = Sensor;
+	Slot.Time = Time;
+	FMemory::Memzero(Slot.Data, sizeof(Slot.Data));
+	FMemory::Memcpy(Slot.Data, Data, FMath::Clamp<int32>(NumData, 0, ARRAY_COUNT(Slot.Data)) * sizeof(double));
+
+	FPlatformMisc::MemoryBarrier();
+	Slot.Sequence = SampleIndex + 1;
+	FPlatformMisc::MemoryBarrier();
+	Header->WriteCount = SampleIndex + 1;
+}
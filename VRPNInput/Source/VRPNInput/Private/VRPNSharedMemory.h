@@ -0,0 +1,153 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * Reads VRPN samples from a shared memory ring buffer instead of a VRPN connection.
+ * This is used with the address scheme shm://Name (e.g. shm://Tracker0) for VRPN servers that run on the same machine,
+ * a small bridge process connects to the VRPN server (or the device SDK) and writes every report into the ring.
+ * This avoids the loopback network stack and the syscalls of mainloop().
+ *
+ * The region is a FVRPNSharedMemoryHeader followed by Capacity samples. The bridge is the only writer, for sample N it:
+ *  1. sets Sequence of slot N % Capacity to 0,
+ *  2. writes the sample data,
+ *  3. sets Sequence to N + 1 and then WriteCount to N + 1 (both with a release barrier).
+ * A reader can never block the bridge, if a reader falls behind by more than Capacity samples it skips ahead.
+ *
+ * Every time the bridge creates the region it writes a new Session. When the Session changes, or WriteCount goes back,
+ * the bridge was restarted and the reader maps the region again and starts reading from the new session.
+ */
+
+#define VRPN_SHARED_MEMORY_MAGIC 0x4D485356 // "VSHM"
+#define VRPN_SHARED_MEMORY_VERSION 2
+
+enum class EVRPNSharedMemorySampleType : int32
+{
+	Tracker = 0,	// Sensor is the sensor id, Data[0..2] is the position and Data[3..6] the quaternion
+	Button = 1,		// Sensor is the button id, Data[0] is the state (0 or 1)
+	Analog = 2		// Sensor is the channel index, Data[0] is the value
+};
+
+struct FVRPNSharedMemoryHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 Capacity;
+	// Different every time the region is created, never zero
+	volatile uint32 Session;
+	volatile int64 WriteCount;
+};
+
+struct FVRPNSharedMemorySample
+{
+	volatile int64 Sequence;
+	EVRPNSharedMemorySampleType Type;
+	int32 Sensor;
+	// Time of the sample in seconds since the epoch, the same as the msg_time of a VRPN report
+	double Time;
+	double Data[7];
+};
+
+/*
+ * Samples that a device polls instead of using a VRPN connection, either from shared memory or from FVRPNSimulatedSource.
+ */
+class IVRPNSampleSource
+{
+public:
+	virtual ~IVRPNSampleSource() {}
+
+	/*
+	 * Copies the samples that arrived since the last call into OutSamples and returns how many were copied.
+	 * Samples that do not fit are returned by the next call.
+	 */
+	virtual int32 Poll(FVRPNSharedMemorySample *OutSamples, int32 MaxSamples) = 0;
+
+	// Number of samples that were lost before they could be read
+	virtual int64 GetNumLostSamples() const = 0;
+};
+
+class FVRPNSharedMemoryReader : public IVRPNSampleSource
+{
+public:
+	static bool IsSharedMemoryAddress(const FString &Address);
+
+	FVRPNSharedMemoryReader(const FString &Address);
+	virtual ~FVRPNSharedMemoryReader();
+
+	int32 Poll(FVRPNSharedMemorySample *OutSamples, int32 MaxSamples) override;
+
+	// Number of samples that were overwritten before this reader could read them
+	int64 GetNumLostSamples() const override { return NumLostSamples; }
+
+private:
+	// The bridge may be started after the engine, so we keep trying to open the region.
+	// After a restart of the bridge all samples of the new session are read, otherwise only the newest.
+	bool TryOpen(bool bFromStart);
+	void Close();
+
+	// Maps only the header of the region by name and copies it, false when the region does not exist
+	bool ReadRegionHeader(FVRPNSharedMemoryHeader &OutHeader) const;
+	// Closes and opens the region again when the bridge was restarted, returns false when it is not open afterwards
+	bool CheckSession(int64 WriteCount);
+
+	FString RegionName;
+	FPlatformMemory::FSharedMemoryRegion *Region;
+	const FVRPNSharedMemoryHeader *Header;
+	const FVRPNSharedMemorySample *Samples;
+
+	uint32 Session;
+	int64 ReadCount;
+	int64 NumLostSamples;
+	// Also the time the region was last checked for a new session while no samples arrive
+	double LastOpenAttemptTime;
+	// A region whose header is not written yet is only reported once
+	bool bWarnedInvalidHeader;
+};
+
+/*
+ * Creates a shared memory region and writes samples into it following the protocol above.
+ * This is the writing side of a bridge process, it only depends on Core. The tests of the plugin use it to feed the devices.
+ */
+class FVRPNSharedMemoryWriter
+{
+public:
+	FVRPNSharedMemoryWriter(const FString &Name, uint32 InCapacity);
+	~FVRPNSharedMemoryWriter();
+
+	// False when the region could not be created
+	bool IsValid() const { return Header != nullptr; }
+
+	/*
+	 * Writes a single sample, Data has up to 7 values (see EVRPNSharedMemorySampleType).
+	 * Time is in seconds since the epoch like the msg_time of a VRPN report.
+	 */
+	void Write(EVRPNSharedMemorySampleType Type, int32 Sensor, double Time, const double *Data, int32 NumData);
+
+private:
+	FPlatformMemory::FSharedMemoryRegion *Region;
+	FVRPNSharedMemoryHeader *Header;
+	FVRPNSharedMemorySample *Samples;
+	uint32 Capacity;
+};
@@ -0,0 +1,127 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNSimulatedSource.h"
+
+namespace
+{
+	const TCHAR *SimulatedScheme = TEXT("sim://");
+	const float DefaultRate = 1000.0f;
+	// A source that was not polled for longer than this (e.g. during a hitch or a breakpoint) skips ahead instead of catching up
+	const double MaxCatchUpTime = 1.0;
+	// Angular speed of the trackers and the analog channels in radians per second
+	const double MotionSpeed = 1.0;
+}
+
+bool FVRPNSimulatedSource::IsSimulatedAddress(const FString &Address)
+{
+	return Address.StartsWith(SimulatedScheme);
+}
+
+FVRPNSimulatedSource::FVRPNSimulatedSource(const FString &Address, EVRPNSharedMemorySampleType InType):
+Type(InType),
+ReportInterval(1.0 / DefaultRate),
+NumSensors(1),
+ReportsPerButtonState(1),
+NextReportTime(0.0),
+ReportIndex(0),
+NextSensor(0),
+NumLostSamples(0)
+{
+	const FString Options = Address.RightChop(FCString::Strlen(SimulatedScheme));
+	float Rate = DefaultRate;
+	if(FParse::Value(*Options, TEXT("Rate="), Rate) && Rate <= 0.0f)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Rate of simulated device %s should be larger than zero. Using %.0f reports per second."), *Address, DefaultRate);
+		Rate = DefaultRate;
+	}
+	ReportInterval = 1.0 / Rate;
+	FParse::Value(*Options, TEXT("Sensors="), NumSensors);
+	NumSensors = FMath::Max(NumSensors, 1);
+	FParse::Value(*Options, TEXT("Hold="), ReportsPerButtonState);
+	ReportsPerButtonState = FMath::Max(ReportsPerButtonState, 1);
+	UE_LOG(LogVRPNInputDevice, Log, TEXT("Simulating %i sensors at %.0f reports per second for %s."), NumSensors, Rate, *Address);
+}
+
+int32 FVRPNSimulatedSource::Poll(FVRPNSharedMemorySample *OutSamples, int32 MaxSamples)
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+	if(NextReportTime == 0.0)
+	{
+		NextReportTime = CurrentTime;
+	}
+	else if(CurrentTime - NextReportTime > MaxCatchUpTime)
+	{
+		const int64 NumSkippedReports = static_cast<int64>((CurrentTime - NextReportTime) / ReportInterval);
+		NumLostSamples += NumSkippedReports * NumSensors - NextSensor;
+		ReportIndex += NumSkippedReports;
+		NextReportTime += NumSkippedReports * ReportInterval;
+		NextSensor = 0;
+	}
+
+	int32 NumSamples = 0;
+	while(NumSamples < MaxSamples && NextReportTime <= CurrentTime)
+	{
+		GenerateSample(OutSamples[NumSamples++]);
+		if(++NextSensor == NumSensors)
+		{
+			NextSensor = 0;
+			++ReportIndex;
+			NextReportTime += ReportInterval;
+		}
+	}
+	return NumSamples;
+}
+
+void FVRPNSimulatedSource::GenerateSample(FVRPNSharedMemorySample &OutSample) const
+{
+	OutSample.Sequence = ReportIndex + 1;
+	OutSample.Type = Type;
+	OutSample.Sensor = NextSensor;
+	// The local clock is used as the server clock, the estimated clock offset is then close to zero
+	OutSample.Time = NextReportTime;
+	FMemory::Memzero(OutSample.Data, sizeof(OutSample.Data));
+
+	// Wrapped before it is converted to float, the local clock can be far from zero
+	const double Angle = NextReportTime * MotionSpeed + NextSensor * (2.0 * PI / NumSensors);
+	const float Phase = static_cast<float>(Angle - 2.0 * PI * FMath::FloorToDouble(Angle / (2.0 * PI)));
+	switch(Type)
+	{
+	case EVRPNSharedMemorySampleType::Tracker:
+		OutSample.Data[0] = FMath::Cos(Phase);
+		OutSample.Data[1] = FMath::Sin(Phase);
+		OutSample.Data[2] = 1.5;
+		// Rotation of Phase around the Z axis, as X, Y, Z and W
+		OutSample.Data[5] = FMath::Sin(Phase * 0.5f);
+		OutSample.Data[6] = FMath::Cos(Phase * 0.5f);
+		break;
+	case EVRPNSharedMemorySampleType::Button:
+		OutSample.Data[0] = static_cast<double>((ReportIndex / ReportsPerButtonState + NextSensor) & 1);
+		break;
+	case EVRPNSharedMemorySampleType::Analog:
+		OutSample.Data[0] = FMath::Sin(Phase);
+		break;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNSharedMemory.h"
+
+/*
+ * Generates synthetic samples instead of reading them from a VRPN server, used to stress and soak test the devices.
+ * This is used with the address scheme sim://Rate=1000,Sensors=64 where Rate is the number of reports per second
+ * of every sensor (default 1000) and Sensors the number of sensors with ids 0 to Sensors - 1 (default 1).
+ * Buttons keep their state for Hold reports (default 1, a new state on every report). Buttons that change more than once per frame
+ * are a stress test, the device then sends only the last press and release and counts the rest as dropped events.
+ * With a Hold that is longer than a frame every change gives an event, which is what a soak test checks.
+ *
+ * The samples are generated for the time that passed since the last poll, so the rate does not depend on the frame rate.
+ * Trackers move on a circle and rotate around the Z axis, buttons alternate between pressed and released
+ * and analog channels follow a sine, each sensor with its own phase.
+ */
+class FVRPNSimulatedSource : public IVRPNSampleSource
+{
+public:
+	static bool IsSimulatedAddress(const FString &Address);
+
+	// Type is the type of the samples that are generated, this should match the device that polls the source
+	FVRPNSimulatedSource(const FString &Address, EVRPNSharedMemorySampleType InType);
+
+	int32 Poll(FVRPNSharedMemorySample *OutSamples, int32 MaxSamples) override;
+
+	// Reports that were skipped because the source was not polled for longer than MaxCatchUpTime
+	int64 GetNumLostSamples() const override { return NumLostSamples; }
+
+private:
+	void GenerateSample(FVRPNSharedMemorySample &OutSample) const;
+
+	EVRPNSharedMemorySampleType Type;
+	double ReportInterval;
+	int32 NumSensors;
+	int32 ReportsPerButtonState;
+
+	// Time and number of the report that is generated next, a report has a sample for every sensor
+	double NextReportTime;
+	int64 ReportIndex;
+	int32 NextSensor;
+
+	int64 NumLostSamples;
+};
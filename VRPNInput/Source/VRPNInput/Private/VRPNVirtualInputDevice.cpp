@@ -0,0 +1,451 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "VRPNInputPrivatePCH.h"
+#include "VRPNVirtualInputDevice.h"
+
+VRPNVirtualInputDevice::VRPNVirtualInputDevice(FCriticalSection& InCritSect):
+IVRPNInputDevice(InCritSect)
+{
+}
+
+bool VRPNVirtualInputDevice::ParseConfig(FConfigSection *InConfigSection) {
+	TArray<const FConfigValue*> NodeStrings;
+	InConfigSection->MultiFindPointer(FName(TEXT("Node")), NodeStrings);
+	if(NodeStrings.Num() == 0)
+	{
+		UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config file for virtual device has no nodes specified. Expeted field Node."));
+		return false;
+	}
+
+	for(const FConfigValue* NodeString: NodeStrings)
+	{
+		const TCHAR *NodeConfig = *NodeString->GetValue();
+		FString NodeName;
+		FString OpString;
+		FString NodeDescription;
+		if(!FParse::Value(NodeConfig, TEXT("Name="), NodeName) ||
+		   !FParse::Value(NodeConfig, TEXT("Op="), OpString) ||
+		   !FParse::Value(NodeConfig, TEXT("Description="), NodeDescription))
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Config not parse node. Expected: Node = (Name=String Op=Axis|Threshold|Chord|RelativePose Description=String ...)."));
+			continue;
+		}
+
+		VirtualNode Node;
+		Node.Name = FName(*NodeName);
+		Node.Scale = 1.0f;
+		Node.Offset = 0.0f;
+		Node.Deadzone = 0.0f;
+		Node.OnValue = 0.5f;
+		Node.bMuteInputs = false;
+		ResetNodeState(Node);
+
+		int32 NumInputs = 1;
+		if(OpString.Equals("Axis"))
+		{
+			Node.Op = ENodeOp::Axis;
+		}
+		else if(OpString.Equals("Threshold"))
+		{
+			Node.Op = ENodeOp::Threshold;
+		}
+		else if(OpString.Equals("Chord"))
+		{
+			Node.Op = ENodeOp::Chord;
+			NumInputs = 0;
+		}
+		else if(OpString.Equals("RelativePose"))
+		{
+			Node.Op = ENodeOp::RelativePose;
+			NumInputs = 2;
+		}
+		else
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Op of node %s should be Axis, Threshold, Chord or RelativePose but found %s. Skipping this node."), *NodeName, *OpString);
+			continue;
+		}
+
+		TArray<FString> InputNames;
+		FString InputString;
+		if(Node.Op == ENodeOp::Chord)
+		{
+			// Inputs=ButtonA+ButtonB
+			if(FParse::Value(NodeConfig, TEXT("Inputs="), InputString))
+			{
+				InputString.ParseIntoArray(InputNames, TEXT("+"), true);
+			}
+			NumInputs = FMath::Max(InputNames.Num(), 1);
+		}
+		else if(FParse::Value(NodeConfig, TEXT("Input="), InputString))
+		{
+			InputNames.Add(InputString);
+		}
+		if(Node.Op == ENodeOp::RelativePose && FParse::Value(NodeConfig, TEXT("Reference="), InputString))
+		{
+			InputNames.Add(InputString);
+		}
+		if(InputNames.Num() != NumInputs)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Node %s does not have the right inputs. Axis and Threshold need Input=Axis, Chord needs Inputs=Button+Button and RelativePose needs Input=Tracker Reference=Tracker."), *NodeName);
+			continue;
+		}
+		for(const FString &InputName : InputNames)
+		{
+			Node.Inputs.Add({FName(*InputName), nullptr, INDEX_NONE});
+		}
+
+		FParse::Value(NodeConfig, TEXT("Scale="), Node.Scale);
+		FParse::Value(NodeConfig, TEXT("Offset="), Node.Offset);
+		FParse::Value(NodeConfig, TEXT("Deadzone="), Node.Deadzone);
+		Node.Deadzone = FMath::Abs(Node.Deadzone);
+		if(Node.Deadzone >= 1.0f)
+		{
+			UE_LOG(LogVRPNInputDevice, Warning, TEXT("Node %s has a deadzone of %f, it should be below 1. The deadzone is not used."), *NodeName, Node.Deadzone);
+			Node.Deadzone = 0.0f;
+		}
+		FParse::Value(NodeConfig, TEXT("On="), Node.OnValue);
+		Node.OffValue = Node.OnValue;
+		FParse::Value(NodeConfig, TEXT("Off="), Node.OffValue);
+		// With Off above On a value between the two would press and release the button in turns every frame
+		Node.OffValue = FMath::Min(Node.OffValue, Node.OnValue);
+		FParse::Bool(NodeConfig, TEXT("MuteInputs="), Node.bMuteInputs);
+
+		switch(Node.Op)
+		{
+		case ENodeOp::Axis:
+			Node.Keys[0] = FKey(Node.Name);
+			KeyDetails.Add(FKeyDetails(Node.Keys[0], FText::FromString(NodeDescription), FKeyDetails::FloatAxis));
+			break;
+		case ENodeOp::Threshold:
+		case ENodeOp::Chord:
+			Node.Keys[0] = FKey(Node.Name);
+			KeyDetails.Add(FKeyDetails(Node.Keys[0], FText::FromString(NodeDescription), FKeyDetails::GamepadKey));
+			break;
+		case ENodeOp::RelativePose:
+			for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
+			{
+				Node.Keys[Axis] = FKey(*(NodeName + PoseAxisKeySuffixes[Axis]));
+				KeyDetails.Add(FKeyDetails(Node.Keys[Axis], FText::FromString(NodeName + PoseAxisDescriptions[Axis]), FKeyDetails::FloatAxis));
+			}
+			break;
+		}
+
+		UE_LOG(LogVRPNInputDevice, Log, TEXT("Adding new virtual node: [%s,%s,%s]."), *NodeName, *OpString, *NodeDescription);
+		Nodes.Add(Node);
+	}
+
+	return Nodes.Num() > 0;
+}
+
+void VRPNVirtualInputDevice::SerializeDeviceConfig(FArchive &Ar) {
+	int32 NumNodes = Nodes.Num();
+	Ar << NumNodes;
+	if(Ar.IsLoading())
+	{
+		Nodes.SetNum(FMath::Max(NumNodes, 0));
+	}
+	for(VirtualNode &Node : Nodes)
+	{
+		uint8 Op = static_cast<uint8>(Node.Op);
+		Ar << Op << Node.Name;
+		Node.Op = static_cast<ENodeOp>(Op);
+
+		int32 NumInputs = Node.Inputs.Num();
+		Ar << NumInputs;
+		if(Ar.IsLoading())
+		{
+			Node.Inputs.SetNum(FMath::Max(NumInputs, 0));
+		}
+		for(NodeInput &Input : Node.Inputs)
+		{
+			Ar << Input.Name;
+		}
+
+		for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
+		{
+			FName KeyName = Node.Keys[Axis].GetFName();
+			Ar << KeyName;
+			if(Ar.IsLoading())
+			{
+				Node.Keys[Axis] = FKey(KeyName);
+			}
+		}
+		Ar << Node.Scale << Node.Offset << Node.Deadzone << Node.OnValue << Node.OffValue << Node.bMuteInputs;
+		if(Ar.IsError())
+		{
+			return;
+		}
+		if(Ar.IsLoading())
+		{
+			ResetNodeState(Node);
+		}
+	}
+}
+
+void VRPNVirtualInputDevice::ResetNodeState(VirtualNode &Node) {
+	Node.bResolved = false;
+	FMemory::Memzero(Node.Values, sizeof(Node.Values));
+	Node.bPressed = false;
+	Node.Position = FVector::ZeroVector;
+	Node.Rotation = FQuat::Identity;
+	Node.bHasOutput = false;
+	Node.MutedKeys = 0;
+}
+
+void VRPNVirtualInputDevice::ResolveInputs(const TArray<IVRPNInputDevice*> &Devices) {
+	for(VirtualNode &Node : Nodes)
+	{
+		Node.bResolved = true;
+		for(NodeInput &Input : Node.Inputs)
+		{
+			Input.Device = nullptr;
+			Input.Index = INDEX_NONE;
+			for(IVRPNInputDevice *Device : Devices)
+			{
+				switch(Node.Op)
+				{
+				case ENodeOp::Axis:
+				case ENodeOp::Threshold:
+					Input.Index = Device->FindAxis(Input.Name);
+					break;
+				case ENodeOp::Chord:
+					Input.Index = Device->FindButton(Input.Name);
+					break;
+				case ENodeOp::RelativePose:
+					Input.Index = Device->FindPose(Input.Name);
+					break;
+				}
+				if(Input.Index != INDEX_NONE)
+				{
+					Input.Device = Device;
+					break;
+				}
+			}
+			if(Input.Device == nullptr)
+			{
+				UE_LOG(LogVRPNInputDevice, Warning, TEXT("Virtual device %s: could not find input %s of node %s. The node is disabled."), *DeviceName, *Input.Name.ToString(), *Node.Name.ToString());
+				Node.bResolved = false;
+			}
+		}
+	}
+
+	// Only after all inputs are found, muting does not change what the Find functions return
+	for(VirtualNode &Node : Nodes)
+	{
+		if(!Node.bResolved || !Node.bMuteInputs)
+		{
+			continue;
+		}
+		for(NodeInput &Input : Node.Inputs)
+		{
+			switch(Node.Op)
+			{
+			case ENodeOp::Axis:
+			case ENodeOp::Threshold:
+				Input.Device->MuteAxis(Input.Index);
+				break;
+			case ENodeOp::Chord:
+				Input.Device->MuteButton(Input.Index);
+				break;
+			case ENodeOp::RelativePose:
+				Input.Device->MutePose(Input.Index);
+				break;
+			}
+		}
+	}
+}
+
+void VRPNVirtualInputDevice::Update() {
+	const FModifierKeysState ModifierKeys = GetModifierKeys();
+	for(VirtualNode &Node : Nodes)
+	{
+		if(!Node.bResolved)
+		{
+			continue;
+		}
+		switch(Node.Op)
+		{
+		case ENodeOp::Axis:
+		{
+			const float Value = Node.Inputs[0].Device->GetAxis(Node.Inputs[0].Index);
+			const float Magnitude = FMath::Abs(Value);
+			// Outside the deadzone the range is stretched back to [-1, 1], so the output does not jump at the edge of the deadzone
+			const float Rescaled = Magnitude <= Node.Deadzone ? 0.0f : FMath::Sign(Value) * (Magnitude - Node.Deadzone) / (1.0f - Node.Deadzone);
+			SendAxis(Node, 0, Rescaled * Node.Scale + Node.Offset, ModifierKeys);
+			Node.bHasOutput = true;
+			break;
+		}
+		case ENodeOp::Threshold:
+		{
+			const float Value = Node.Inputs[0].Device->GetAxis(Node.Inputs[0].Index);
+			SendButton(Node, Node.bPressed ? Value > Node.OffValue : Value >= Node.OnValue, ModifierKeys);
+			break;
+		}
+		case ENodeOp::Chord:
+		{
+			bool bAllPressed = true;
+			for(const NodeInput &Input : Node.Inputs)
+			{
+				bAllPressed = bAllPressed && Input.Device->GetButton(Input.Index);
+			}
+			SendButton(Node, bAllPressed, ModifierKeys);
+			break;
+		}
+		case ENodeOp::RelativePose:
+		{
+			FVector InputPosition;
+			FQuat InputRotation;
+			FVector ReferencePosition;
+			FQuat ReferenceRotation;
+			if(!Node.Inputs[0].Device->GetPose(Node.Inputs[0].Index, InputPosition, InputRotation) ||
+			   !Node.Inputs[1].Device->GetPose(Node.Inputs[1].Index, ReferencePosition, ReferenceRotation))
+			{
+				break;
+			}
+			const FQuat InverseReferenceRotation = ReferenceRotation.Inverse();
+			Node.Position = InverseReferenceRotation.RotateVector(InputPosition - ReferencePosition);
+			Node.Rotation = InverseReferenceRotation * InputRotation;
+			const FRotator Rotator = Node.Rotation.Rotator();
+			for(int32 Axis = 0; Axis < NumPoseAxes; ++Axis)
+			{
+				SendAxis(Node, Axis, GetPoseAxis(Node.Position, Rotator, Axis), ModifierKeys);
+			}
+			Node.bHasOutput = true;
+			break;
+		}
+		}
+	}
+}
+
+void VRPNVirtualInputDevice::SendAxis(VirtualNode &Node, int32 Axis, float Value, const FModifierKeysState &ModifierKeys) {
+	if(Node.bHasOutput && Node.Values[Axis] == Value)
+	{
+		return;
+	}
+	Node.Values[Axis] = Value;
+	if(Node.MutedKeys & (1 << Axis))
+	{
+		return;
+	}
+	SendAxisEvent(Node.Keys[Axis], Value, ModifierKeys);
+	++Stats.NumEvents;
+}
+
+void VRPNVirtualInputDevice::SendButton(VirtualNode &Node, bool bPressed, const FModifierKeysState &ModifierKeys) {
+	if(Node.bPressed == bPressed)
+	{
+		return;
+	}
+	Node.bPressed = bPressed;
+	if(Node.MutedKeys & 1)
+	{
+		return;
+	}
+	SendKeyEvent(Node.Keys[0], bPressed, ModifierKeys);
+	++Stats.NumEvents;
+}
+
+int32 VRPNVirtualInputDevice::FindAxis(const FName &Name) const {
+	for(int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		const VirtualNode &Node = Nodes[NodeIndex];
+		const int32 NumAxes = Node.Op == ENodeOp::RelativePose ? NumPoseAxes : (Node.Op == ENodeOp::Axis ? 1 : 0);
+		for(int32 Axis = 0; Axis < NumAxes; ++Axis)
+		{
+			if(Node.Keys[Axis].GetFName() == Name)
+			{
+				return NodeIndex * NumPoseAxes + Axis;
+			}
+		}
+	}
+	return INDEX_NONE;
+}
+
+float VRPNVirtualInputDevice::GetAxis(int32 Index) const {
+	if(Index < 0 || !Nodes.IsValidIndex(Index / NumPoseAxes))
+	{
+		return 0.0f;
+	}
+	return Nodes[Index / NumPoseAxes].Values[Index % NumPoseAxes];
+}
+
+int32 VRPNVirtualInputDevice::FindButton(const FName &Name) const {
+	for(int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		const VirtualNode &Node = Nodes[NodeIndex];
+		if((Node.Op == ENodeOp::Threshold || Node.Op == ENodeOp::Chord) && Node.Name == Name)
+		{
+			return NodeIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool VRPNVirtualInputDevice::GetButton(int32 Index) const {
+	return Nodes.IsValidIndex(Index) && Nodes[Index].bPressed;
+}
+
+int32 VRPNVirtualInputDevice::FindPose(const FName &Name) const {
+	for(int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		const VirtualNode &Node = Nodes[NodeIndex];
+		if(Node.Op == ENodeOp::RelativePose && Node.Name == Name)
+		{
+			return NodeIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void VRPNVirtualInputDevice::MuteAxis(int32 Index) {
+	if(Index >= 0 && Nodes.IsValidIndex(Index / NumPoseAxes))
+	{
+		Nodes[Index / NumPoseAxes].MutedKeys |= 1 << (Index % NumPoseAxes);
+	}
+}
+
+void VRPNVirtualInputDevice::MuteButton(int32 Index) {
+	if(Nodes.IsValidIndex(Index))
+	{
+		Nodes[Index].MutedKeys |= 1;
+	}
+}
+
+void VRPNVirtualInputDevice::MutePose(int32 Index) {
+	if(Nodes.IsValidIndex(Index))
+	{
+		Nodes[Index].MutedKeys = (1 << NumPoseAxes) - 1;
+	}
+}
+
+bool VRPNVirtualInputDevice::GetPose(int32 Index, FVector &OutPosition, FQuat &OutRotation) const {
+	if(!Nodes.IsValidIndex(Index) || !Nodes[Index].bHasOutput)
+	{
+		return false;
+	}
+	OutPosition = Nodes[Index].Position;
+	OutRotation = Nodes[Index].Rotation;
+	return true;
+}
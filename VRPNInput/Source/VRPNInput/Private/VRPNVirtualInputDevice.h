@@ -0,0 +1,121 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Groningen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "VRPNInputDevice.h"
+
+/*
+ * A device without a VRPN connection whose keys are computed from the keys of the other devices.
+ * Each Node in the config is evaluated after the other devices are updated and only sends an event when its value changed:
+ *   Axis         = Input axis with a deadzone, scale and offset
+ *   Threshold    = button that is pressed when the Input axis goes above On and released when it goes below Off
+ *   Chord        = button that is pressed while all Inputs buttons are pressed
+ *   RelativePose = pose (and its six axes) of the Input tracker in the coordinate frame of the Reference tracker
+ * Nodes can use the keys of other virtual devices and of other nodes, a node declared later gives the value of the previous frame.
+ * With MuteInputs=True the keys that a node uses as its inputs no longer send events themselves, only the node does.
+ */
+class VRPNVirtualInputDevice : public IVRPNInputDevice
+{
+public:
+	VRPNVirtualInputDevice(FCriticalSection& InCritSect);
+
+	void Update() override;
+	bool ParseConfig(FConfigSection *InConfigSection) override;
+	// The inputs are replicated, so every node computes the same values
+	void SerializeClusterState(FArchive &Ar) override {}
+	vrpn_BaseClass* GetRemote() const override { return nullptr; }
+
+	/*
+	 * Looks up the inputs of the nodes in the given devices, call this after all devices are parsed.
+	 * Nodes with an input that can not be found are disabled.
+	 */
+	void ResolveInputs(const TArray<IVRPNInputDevice*> &Devices);
+
+	// The index of an axis is NodeIndex * NumPoseAxes + Axis, the index of a button or pose is the node index
+	int32 FindAxis(const FName &Name) const override;
+	float GetAxis(int32 Index) const override;
+	int32 FindButton(const FName &Name) const override;
+	bool GetButton(int32 Index) const override;
+	int32 FindPose(const FName &Name) const override;
+	bool GetPose(int32 Index, FVector &OutPosition, FQuat &OutRotation) const override;
+	void MuteAxis(int32 Index) override;
+	void MuteButton(int32 Index) override;
+	void MutePose(int32 Index) override;
+
+private:
+	enum class ENodeOp
+	{
+		Axis,
+		Threshold,
+		Chord,
+		RelativePose
+	};
+
+	struct NodeInput
+	{
+		FName Name;
+		IVRPNInputDevice *Device;
+		int32 Index;
+	};
+
+	struct VirtualNode
+	{
+		ENodeOp Op;
+		FName Name;
+		TArray<NodeInput> Inputs;
+		bool bResolved;
+
+		// Only the first key is used, except for RelativePose that has a key for every pose axis
+		FKey Keys[NumPoseAxes];
+
+		float Scale;
+		float Offset;
+		float Deadzone;
+		float OnValue;
+		float OffValue;
+		bool bMuteInputs;
+
+		// Bit N is set when Keys[N] does not send events because another node consumes it
+		uint8 MutedKeys;
+
+		// The output of the last evaluation, only used on the game thread
+		float Values[NumPoseAxes];
+		bool bPressed;
+		FVector Position;
+		FQuat Rotation;
+		bool bHasOutput;
+	};
+
+	void SerializeDeviceConfig(FArchive &Ar) override;
+	// Clears the output and the resolved inputs of a node
+	void ResetNodeState(VirtualNode &Node);
+
+	// Sends an axis event when the value changed since the last event
+	void SendAxis(VirtualNode &Node, int32 Axis, float Value, const FModifierKeysState &ModifierKeys);
+	// Sends a key down or up event when the state changed
+	void SendButton(VirtualNode &Node, bool bPressed, const FModifierKeysState &ModifierKeys);
+
+	TArray<VirtualNode> Nodes;
+};
@@ -56,6 +56,15 @@ public:
 	 * Get the mutex for the critical section that is used before any mainloop() call to the VRPN
 	 * VRPN seems to merge connections that are using the same address.
 	 * So if you use VRPN somewhere outside you program you might need to lock this mutex when calling mainloop.
+	 * The polling threads of -VRPNPollingMode=Event and BusyPoll also hold this lock while they call mainloop() of the remotes.
+	 * In Event mode they wait for data on their connection without the lock, do not poll a connection to the same address yourself in that mode.
 	 */
 	virtual FCriticalSection& GetVRPNLock() = 0;
+
+	/**
+	 * Returns the latest received state of a button, DeviceName is the name of the config section of the Button device.
+	 * This does not lock and can be called from any thread, e.g. to sample a button on the render thread.
+	 * Returns false when there is no such device or button.
+	 */
+	virtual bool IsButtonPressed(const FString &DeviceName, int32 ButtonId) const = 0;
 };
\ No newline at end of file
@@ -41,6 +41,8 @@ namespace UnrealBuildTool.Rules
             PrivateDependencyModuleNames.AddRange(
                 new string[]
                 {
+                    "Sockets",
+                    "Networking"
 					// ... add private dependencies that you statically link with here ...
 				}
                 );